@@ -6,6 +6,12 @@
 #include <typeinfo>
 #include <tuple>
 #include <utility>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <cstddef>
+#include <new>
 
 namespace tpack
 {
@@ -290,6 +296,21 @@ struct SizeOffset2 : _SizeOffset2<N, max_alignof<Us...>() , T, Us...> {};
 
 
 
+// Zwraca offset w bajtach typu o podanym indexie jesli obiekty podanych typow zostana umieszczone w pamieci
+// w podanej kolejnosci z uwzglednieniem align (tak jak w aligned_storage<Us...>).
+// Przyklad uzycia: aligned_offset<2, char, short, float>(); // <--- 4 bo 1 + 1p + 2
+template <size_t index, typename... Us>
+constexpr size_t aligned_offset()
+{
+	static_assert(index < sizeof...(Us), "index has to be < sizeof...(Us)");
+	size_t size = 0u, offset = 0u, i = 0u;
+	using Swallow = int[];
+	(void)Swallow{0, (void(( size += (alignof(Us) - size) % alignof(Us), offset = (i++ == index) ? size : offset, size += sizeof(Us) )), 0)... };
+	return offset;
+}
+
+
+
 // -------------- ZLOZONE OPERACJE NA PACZCE TYPOW -------------- //
 
 
@@ -357,8 +378,11 @@ struct remove_back<count> { using type = TypePack<>; };
 template<typename...Us>
 struct remove_back<0u, Us...> { using type = TypePack<Us...>; };
 
+template<>
+struct remove_back<0u> { using type = TypePack<>; };
+
 template<size_t count, typename... Vs>
-struct remove_back<count, Vs...> : Impl::remove_back<TypePack<>, count, sizeof...(Vs), Vs...>
+struct remove_back : Impl::remove_back<TypePack<>, count, sizeof...(Vs), Vs...>
 {
 	static_assert(count <= sizeof...(Vs), "Count is to big. There is nothing else to remove.");
 };
@@ -523,7 +547,7 @@ struct unpack_from<U<Ts...>> { using type = TypePack<Ts...>; };
 // zostanie podana paczka  typow to jej zawartosc nie bedzie wycigana. Typ paczki typow bedzie traktowany jako osobny typ.
 // Przyklad uzycia: divide<2, int, long, char, float, void>::type // <--- to samo co TypePack<TypePack<int, long>, TypePack<char, float>, TypePack<void>>
 template<size_t count, typename...Ts>
-struct divide {};
+struct divide;
 
 namespace Impl
 {
@@ -548,8 +572,176 @@ struct divide<0u, Us...> { static_assert(0* sizeof...(Us), "U can't divide by ze
 template<typename...Us>
 struct divide<1u, Us...> { using type = TypePack<TypePack<Us>...>; };
 
+template<>
+struct divide<1u> { using type = TypePack<>; };
+
 template<size_t count, typename...Vs>
-struct divide<count, Vs...> : Impl::divide<TypePack<>, TypePack<>, count, 0, Vs...> {};
+struct divide : Impl::divide<TypePack<>, TypePack<>, count, 0, Vs...> {};
+
+
+// -------------- LENIWE POTOKI (PIPE) OPERACJI NA PACZCE TYPOW -------------- //
+
+
+// Etapy potoku. Kazdy etap to klasa z polem 'state' (poczatkowy stan etapu, void dla etapow bezstanowych),
+// stala 'may_drop' (czy etap moze odrzucic typ) oraz szablonem apply<State, T>, ktory dla pojedynczego typu
+// zwraca typ wynikowy (lub Impl::pipe_drop gdy typ ma zostac odrzucony) oraz nowy stan etapu.
+// Dzieki temu mozna dopisac wlasne etapy nie zmieniajac samego potoku.
+namespace Impl
+{
+	struct pipe_drop {};
+}
+
+namespace stage
+{
+	// Odpowiednik filter<F, ...> - zostawia tylko typy dla ktorych F<T>::value jest prawdziwe.
+	template<template<typename>typename F>
+	struct filter
+	{
+		using state = void;
+		static constexpr bool may_drop = true;
+
+		template<typename State, typename T>
+		struct apply
+		{
+			using type  = typename std::conditional<F<T>::value, T, Impl::pipe_drop>::type;
+			using state = State;
+		};
+	};
+
+	// Odpowiednik filter_inv<F, ...> - zostawia tylko typy dla ktorych F<T>::value jest falszywe.
+	template<template<typename>typename F>
+	struct filter_inv
+	{
+		using state = void;
+		static constexpr bool may_drop = true;
+
+		template<typename State, typename T>
+		struct apply
+		{
+			using type  = typename std::conditional<F<T>::value, Impl::pipe_drop, T>::type;
+			using state = State;
+		};
+	};
+
+	// Odpowiednik modify<F, ...> - zamienia typ T na F<T>::type.
+	template<template<typename>typename F>
+	struct modify
+	{
+		using state = void;
+		static constexpr bool may_drop = false;
+
+		template<typename State, typename T>
+		struct apply
+		{
+			using type  = typename F<T>::type;
+			using state = State;
+		};
+	};
+
+	// Odpowiednik remove_repetitions<...> - stanem jest paczka typow ktore juz przeszly przez ten etap.
+	struct remove_repetitions
+	{
+		using state = TypePack<>;
+		static constexpr bool may_drop = true;
+
+		template<typename State, typename T>
+		struct apply;
+
+		template<typename... Ss, typename T>
+		struct apply<TypePack<Ss...>, T>
+		{
+			using type  = typename std::conditional<contains<T, Ss...>(), Impl::pipe_drop, T>::type;
+			using state = typename std::conditional<contains<T, Ss...>(), TypePack<Ss...>, TypePack<Ss..., T>>::type;
+		};
+	};
+
+	// Zostawia tylko count pierwszych typow ktore dotarly do tego etapu - stanem jest licznik typow.
+	template<size_t count>
+	struct take
+	{
+		using state = std::integral_constant<size_t, 0u>;
+		static constexpr bool may_drop = true;
+
+		template<typename State, typename T>
+		struct apply
+		{
+			using type  = typename std::conditional<(State::value < count), T, Impl::pipe_drop>::type;
+			using state = std::integral_constant<size_t, State::value + 1u>;
+		};
+	};
+}
+
+
+
+// Przyjmuje paczke typow oraz dowolna ilosc etapow (z przestrzeni nazw stage) i zwraca paczke typow bedaca wynikiem
+// przepuszczenia kazdego typu przez wszystkie etapy po kolei. W przeciwienstwie do lancucha filter/modify/... nie sa
+// tworzone posrednie paczki typow - wszystkie etapy sa skladane w jedna operacje na pojedynczym typie, a wynikowa
+// paczka jest budowana tylko raz. Jesli zaden etap nie moze odrzucic typu ani nie ma stanu to wynik jest rozwijany
+// bez rekurencji po typach. Jesli jako typ zostanie podana paczka typow to jej zawartosc nie bedzie wycigana.
+// Przyklad uzycia: pipe<TypePack<int, const int, float>, stage::modify<std::remove_const>, stage::remove_repetitions>::type
+// Wynik:           to samo co TypePack<int, float>
+template<typename TypePack, typename... Stages>
+struct pipe;
+
+namespace Impl
+{
+	// Pojedynczy krok - typ odrzucony przez wczesniejszy etap omija kolejne etapy, ich stan sie nie zmienia.
+	template<typename Stage, typename State, typename T>
+	struct pipe_step : Stage::template apply<State, T> {};
+
+	template<typename Stage, typename State>
+	struct pipe_step<Stage, State, pipe_drop> { using type = pipe_drop; using state = State; };
+
+	// Przepuszcza jeden typ przez wszystkie etapy zbierajac nowe stany etapow w paczce DoneStates.
+	template<typename DoneStates, typename T, typename Stages, typename States>
+	struct pipe_element;
+
+	template<typename... Ds, typename T>
+	struct pipe_element<TypePack<Ds...>, T, TypePack<>, TypePack<>> { using type = T; using states = TypePack<Ds...>; };
+
+	template<typename... Ds, typename T, typename S, typename... Ss, typename St, typename... Sts>
+	struct pipe_element<TypePack<Ds...>, T, TypePack<S, Ss...>, TypePack<St, Sts...>>
+		: pipe_element<TypePack<Ds..., typename pipe_step<S, St, T>::state>, typename pipe_step<S, St, T>::type, TypePack<Ss...>, TypePack<Sts...>> {};
+
+	template<typename TypePack, typename T>
+	struct pipe_push;
+
+	template<typename... Ts, typename T>
+	struct pipe_push<TypePack<Ts...>, T> { using type = TypePack<Ts..., T>; };
+	template<typename... Ts>
+	struct pipe_push<TypePack<Ts...>, pipe_drop> { using type = TypePack<Ts...>; };
+
+	// Jedno przejscie po typach w ktorym przekazywany jest stan wszystkich etapow.
+	template<typename TypePack, typename Stages, typename States, typename... Us>
+	struct pipe_fold { using type = TypePack; };
+
+	template<typename... Ts, typename Stages, typename States, typename U, typename... Us>
+	struct pipe_fold<TypePack<Ts...>, Stages, States, U, Us...> : pipe_fold<
+		typename pipe_push<TypePack<Ts...>, typename pipe_element<TypePack<>, U, Stages, States>::type>::type,
+		Stages, typename pipe_element<TypePack<>, U, Stages, States>::states, Us...> {};
+
+	template<typename... Stages>
+	constexpr bool pipe_is_plain()
+	{
+		bool plain = true;
+		using Swallow = int[];
+		(void)Swallow{0, (void( plain = (!Stages::may_drop && std::is_void<typename Stages::state>::value) ? plain : false ), 0)... };
+		return plain;
+	}
+
+	template<bool plain, typename TypePack, typename... Stages>
+	struct pipe;
+
+	template<typename... Us, typename... Stages>
+	struct pipe<true, TypePack<Us...>, Stages...>
+	{ using type = TypePack<typename pipe_element<TypePack<>, Us, TypePack<Stages...>, TypePack<typename Stages::state...>>::type...>; };
+
+	template<typename... Us, typename... Stages>
+	struct pipe<false, TypePack<Us...>, Stages...> : pipe_fold<TypePack<>, TypePack<Stages...>, TypePack<typename Stages::state...>, Us...> {};
+}
+template<typename... Us, typename... Stages>
+struct pipe<TypePack<Us...>, Stages...> : Impl::pipe<Impl::pipe_is_plain<Stages...>(), TypePack<Us...>, Stages...> {};
+
 
 
 // ---------- FUNKCJE TYPU FOR EACH POZWALAJACE COS ZROBIC NA KAZDYM TYPIE PACZKI ----------//
@@ -614,17 +806,140 @@ struct is_TypePack<T<Ts...>> : std::integral_constant<bool, std::is_same<T<Ts...
 
 
 
+// Sprawdza czy obiekt typu T mozna przeniesc w inne miejsce w pamieci zwyklym memcpy (bez wywolywania
+// konstruktora przenoszacego i destruktora starego obiektu). Domyslnie dotyczy to typow trywialnie
+// kopiowalnych. Dla wlasnych typow ktore nie sa trywialne ale nie trzymaja wskaznikow na samych siebie
+// (np. wlasny unique_ptr lub vector) mozna to zadeklarowac specjalizacja:
+// Przyklad: template<> struct tpack::is_trivially_relocatable<MyVector> : std::true_type {};
+template<typename T>
+struct is_trivially_relocatable : std::integral_constant<bool, std::is_trivially_copyable<T>::value> {};
+
+
+
+// ---------- OPERACJE NA TABLICACH REKORDOW aligned_storage<Us...> ----------//
+
+
+// Funkcje operujace na tablicach rekordow aligned_storage<Us...>, w ktorych kazdy rekord zawiera obiekty
+// wszystkich podanych typow (pod offsetami aligned_offset). Jesli pozwalaja na to cechy calej paczki
+// (sprawdzane przez check_all w trakcie kompilacji) cala tablica jest obslugiwana jednym memcpy / memset
+// lub nie jest wykonywane nic - w przeciwnym wypadku kazdy obiekt jest obslugiwany osobno.
+namespace Impl
+{
+	template<typename... Us, size_t... Is, typename Function>
+	void for_each_object(unsigned char* record, std::index_sequence<Is...>, Function&& f)
+	{
+		using Swallow = int[];
+		(void)Swallow{0, (void( f(reinterpret_cast<Us*>(record + aligned_offset<Is, Us...>())) ), 0)... };
+	}
+
+	// Niszczy pierwsze count obiektow rekordu (w kolejnosci typow w paczce).
+	template<typename... Us>
+	void destroy_first_objects(unsigned char* record, size_t count)
+	{
+		size_t index = 0u;
+		for_each_object<Us...>(record, std::index_sequence_for<Us...>{}, [&](auto* object)
+		{
+			using T = std::remove_pointer_t<decltype(object)>;
+			if (index++ < count)
+				std::launder(object)->~T();
+		});
+	}
+}
+
+
+
+// Niszczy obiekty we wszystkich count rekordach. Gdy wszystkie typy sa trywialnie destruowalne nie robi nic.
+// Przyklad uzycia: destroy_n<int, std::string>(records, 16);
+template<typename... Us>
+void destroy_n(aligned_storage<Us...>* records, size_t count)
+{
+	if constexpr (!check_all<std::is_trivially_destructible, Us...>())
+		for (size_t i = 0u; i < count; ++i)
+			Impl::destroy_first_objects<Us...>(reinterpret_cast<unsigned char*>(records + i), sizeof...(Us));
+}
+
+
+
+// Tworzy obiekty (inicjalizacja wartoscia - T()) we wszystkich count rekordach. Gdy wszystkie typy sa trywialne
+// jest to jedno memset na zero. Uwaga: zakladane jest ze zerowe bajty to T() (nie dotyczy wskaznikow na pola klas).
+// Jesli ktorys konstruktor rzuci wyjatek to juz utworzone obiekty sa niszczone (jak w std::uninitialized_value_construct_n).
+// Przyklad uzycia: uninitialized_construct_n<int, float>(records, 16);
+template<typename... Us>
+void uninitialized_construct_n(aligned_storage<Us...>* records, size_t count)
+{
+	if constexpr (check_all<std::is_trivial, Us...>() && !check_any<std::is_member_pointer, Us...>())
+	{
+		if (count)
+			std::memset(static_cast<void*>(records), 0, count * sizeof(aligned_storage<Us...>));
+	}
+	else
+	{
+		size_t i = 0u, built = 0u;
+		try
+		{
+			for (; i < count; ++i, built = 0u)
+				Impl::for_each_object<Us...>(reinterpret_cast<unsigned char*>(records + i), std::index_sequence_for<Us...>{},
+					[&](auto* object){ new (object) std::remove_pointer_t<decltype(object)>(); ++built; });
+		}
+		catch (...)
+		{
+			Impl::destroy_first_objects<Us...>(reinterpret_cast<unsigned char*>(records + i), built);
+			destroy_n<Us...>(records, i);
+			throw;
+		}
+	}
+}
+
+
+
+// Przenosi obiekty z count rekordow src do niezainicjalizowanych rekordow dst (obszary nie moga na siebie
+// zachodzic). Po wywolaniu obiekty w src nie istnieja. Gdy cala paczka jest trywialnie relokowalna
+// (is_trivially_relocatable) jest to jedno memcpy, w przeciwnym razie przeniesienie i zniszczenie kazdego obiektu.
+// Wtedy konstruktory przenoszace musza byc noexcept - przerwane przenoszenie zostawiloby obie tablice w polowie.
+// Przyklad uzycia: relocate_n<int, std::string>(old_records, size, new_records);
+template<typename... Us>
+void relocate_n(aligned_storage<Us...>* src, size_t count, aligned_storage<Us...>* dst)
+{
+	if constexpr (check_all<is_trivially_relocatable, Us...>())
+	{
+		if (count)
+			std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), count * sizeof(aligned_storage<Us...>));
+	}
+	else
+	{
+		static_assert(check_all<std::is_nothrow_move_constructible, Us...>(), "relocate_n needs nothrow move constructors or is_trivially_relocatable types.");
+		for (size_t i = 0u; i < count; ++i)
+		{
+			unsigned char* from = reinterpret_cast<unsigned char*>(src + i);
+			unsigned char* to   = reinterpret_cast<unsigned char*>(dst + i);
+			Impl::for_each_object<Us...>(from, std::index_sequence_for<Us...>{}, [&](auto* object)
+			{
+				using T = std::remove_pointer_t<decltype(object)>;
+				T* source = std::launder(object);
+				new (to + (reinterpret_cast<unsigned char*>(object) - from)) T(std::move(*source));
+				source->~T();
+			});
+		}
+	}
+}
+
+
+
 // --------- ROZNE PRZYDATNE FUNKCJE TYPU TYPE TRIATS UZYWAJACE TypePack --------//
 
-// Pozwala wypakowac z typu funkcji, lambdy lub też z funktora ktorego operator () NIE jest
-// wielokrotnie przeladowany typ wartosci zwracanej: type_result, oraz paczke typow opisujacych
-// typy parametrow wejsciowych.
+// Pozwala wypakowac z typu funkcji, wskaznika na funkcje, lambdy lub też z funktora ktorego operator () NIE jest
+// wielokrotnie przeladowany typ wartosci zwracanej: type_result, paczke typow opisujacych typy parametrow
+// wejsciowych: type_pack_args, sygnature bez kwalifikatorow: type_signature (np. do inplace_function)
+// oraz informacje czy funkcja jest oznaczona jako noexcept: is_noexcept.
 // Przyklad: functor_traits<std::function<int(char, float)>>::type_result --> int
 // functor_traits<std::function<int(char, float)>>::type_pack_args --> TypePack<char,float>;
+// functor_traits<void(*)(int) noexcept>::type_signature --> void(int)
 // Zasada dzialania: wypakowywany jest typ metody funktora (operatora ()) i pozniej normalnie.
 // const dodane jest w typie metody w specializacji bo funktory sa z natury stale??.
+// Metody z kwalifikatorami &, && oraz noexcept sa sprowadzane do zwyklego typu funkcji.
 // Uwaga: uzywajac std::bind trzeba kastowac do std::function bo w bind podane parametry
 // nie sa pakowane na stale w obiekcie a sa traktowane jako domyslne (mozna dalej podac inne).
+// Uwaga 2: std::function alokuje pamiec dla duzych funktorow - jesli to problem uzyj inplace_function.
 template <class Functor>
 struct function_traits : public function_traits<decltype(&Functor::operator())> {};
 
@@ -633,20 +948,775 @@ struct function_traits<Result(Args...)>
 {
     using type_result    = Result;
     using type_pack_args = TypePack<Args...>;
+    using type_signature = Result(Args...);
+    static constexpr bool is_noexcept = false;
 };
 
-template <class Functor, typename Result, typename... Args>
-struct function_traits<Result(Functor::*)(Args...)>
+template <typename Result, typename... Args>
+struct function_traits<Result(Args...) noexcept> : function_traits<Result(Args...)>
 {
-    using type_result    = Result;
-    using type_pack_args = TypePack<Args...>;
+    static constexpr bool is_noexcept = true;
 };
 
+template <typename Result, typename... Args>
+struct function_traits<Result(*)(Args...)> : function_traits<Result(Args...)> {};
+template <typename Result, typename... Args>
+struct function_traits<Result(*)(Args...) noexcept> : function_traits<Result(Args...) noexcept> {};
+template <typename Result, typename... Args>
+struct function_traits<Result(&)(Args...)> : function_traits<Result(Args...)> {};
+template <typename Result, typename... Args>
+struct function_traits<Result(&)(Args...) noexcept> : function_traits<Result(Args...) noexcept> {};
+
+template <class Functor, typename Result, typename... Args>
+struct function_traits<Result(Functor::*)(Args...)> : function_traits<Result(Args...)> {};
+template <class Functor, typename Result, typename... Args>
+struct function_traits<Result(Functor::*)(Args...) const> : function_traits<Result(Args...)> {};
+template <class Functor, typename Result, typename... Args>
+struct function_traits<Result(Functor::*)(Args...) &> : function_traits<Result(Args...)> {};
+template <class Functor, typename Result, typename... Args>
+struct function_traits<Result(Functor::*)(Args...) const &> : function_traits<Result(Args...)> {};
+template <class Functor, typename Result, typename... Args>
+struct function_traits<Result(Functor::*)(Args...) &&> : function_traits<Result(Args...)> {};
+template <class Functor, typename Result, typename... Args>
+struct function_traits<Result(Functor::*)(Args...) const &&> : function_traits<Result(Args...)> {};
+
+template <class Functor, typename Result, typename... Args>
+struct function_traits<Result(Functor::*)(Args...) noexcept> : function_traits<Result(Args...) noexcept> {};
 template <class Functor, typename Result, typename... Args>
-struct function_traits<Result(Functor::*)(Args...) const>
+struct function_traits<Result(Functor::*)(Args...) const noexcept> : function_traits<Result(Args...) noexcept> {};
+template <class Functor, typename Result, typename... Args>
+struct function_traits<Result(Functor::*)(Args...) & noexcept> : function_traits<Result(Args...) noexcept> {};
+template <class Functor, typename Result, typename... Args>
+struct function_traits<Result(Functor::*)(Args...) const & noexcept> : function_traits<Result(Args...) noexcept> {};
+template <class Functor, typename Result, typename... Args>
+struct function_traits<Result(Functor::*)(Args...) && noexcept> : function_traits<Result(Args...) noexcept> {};
+template <class Functor, typename Result, typename... Args>
+struct function_traits<Result(Functor::*)(Args...) const && noexcept> : function_traits<Result(Args...) noexcept> {};
+
+
+
+// ----------- OPAKOWANIE FUNKCJI BEZ ALOKACJI PAMIECI NA STERCIE -----------//
+
+// Odpowiednik std::function ktory przechowuje funktor (lambde razem z przechwyconymi zmiennymi)
+// wylacznie w wewnetrznym buforze o rozmiarze Capacity - nigdy nie alokuje pamieci. Jesli funktor
+// sie nie miesci lub ma zbyt duzy align kompilacja zakonczy sie bledem (static_assert). Wywolanie
+// to jedno wywolanie funkcji przez wskaznik, kopiowanie/przenoszenie/niszczenie idzie przez tablice
+// operacji wspolna dla danego typu funktora. Wywolanie pustego obiektu (takze utworzonego z pustego
+// wskaznika na funkcje) rzuca bad_inplace_function_call. Funktor musi miec nierzucajacy konstruktor
+// przenoszacy, dzieki temu przenoszenie inplace_function jest noexcept (np. przy powiekszaniu std::vector).
+// Sygnature mozna wydedukowac z lambdy lub wskaznika na funkcje (przez function_traits).
+// Przyklad uzycia: inplace_function<int(int), 16> f = [k](int x){ return x * k; };
+//                  inplace_function g = [](char c){ return c == 'a'; }; // <--- inplace_function<bool(char)>
+template <typename Signature, size_t Capacity = 4u * sizeof(void*), size_t Align = alignof(std::max_align_t)>
+class inplace_function;
+
+// Odpowiednik std::bad_function_call - wlasny typ zeby nie dolaczac ciezkiego <functional>.
+struct bad_inplace_function_call : std::exception
 {
-    using type_result    = Result;
-    using type_pack_args = TypePack<Args...>;
+	const char* what() const noexcept override { return "bad_inplace_function_call"; }
+};
+
+namespace Impl
+{
+	template <typename Result, typename... Args>
+	struct inplace_vtable
+	{
+		Result (*invoke)(void*, Args&&...);
+		void   (*copy)(void* dst, const void* src);
+		void   (*move)(void* dst, void* src);
+		void   (*destroy)(void* f);
+	};
+
+	template <typename Result, typename... Args>
+	struct inplace_empty
+	{
+		static Result invoke(void*, Args&&...) { throw bad_inplace_function_call(); }
+		static void copy(void*, const void*) {}
+		static void move(void*, void*) {}
+		static void destroy(void*) {}
+
+		static constexpr inplace_vtable<Result, Args...> vtable{ &invoke, &copy, &move, &destroy };
+	};
+
+	template <typename Functor, typename Result, typename... Args>
+	struct inplace_ops
+	{
+		static Result invoke(void* f, Args&&... args)
+		{
+			// Przy sygnaturze zwracajacej void wynik funktora jest odrzucany (jak w std::function).
+			if constexpr (std::is_void<Result>::value)
+				(void)(*static_cast<Functor*>(f))(std::forward<Args>(args)...);
+			else
+				return (*static_cast<Functor*>(f))(std::forward<Args>(args)...);
+		}
+		static void copy(void* dst, const void* src) { new (dst) Functor(*static_cast<const Functor*>(src)); }
+		static void move(void* dst, void* src)       { new (dst) Functor(std::move(*static_cast<Functor*>(src))); }
+		static void destroy(void* f)                 { static_cast<Functor*>(f)->~Functor(); }
+
+		static constexpr inplace_vtable<Result, Args...> vtable{ &invoke, &copy, &move, &destroy };
+	};
+}
+
+template <typename Result, typename... Args, size_t Capacity, size_t Align>
+class inplace_function<Result(Args...), Capacity, Align>
+{
+	using vtable_type = Impl::inplace_vtable<Result, Args...>;
+
+public:
+	using result_type = Result;
+
+	inplace_function() noexcept
+		: invoke_(Impl::inplace_empty<Result, Args...>::vtable.invoke), vtable_(&Impl::inplace_empty<Result, Args...>::vtable) {}
+
+	inplace_function(std::nullptr_t) noexcept : inplace_function() {}
+
+	// Konstruktor bierze udzial w rozstrzyganiu przeciazen tylko dla funktorow wywolywalnych z Args...
+	// ktorych wynik konwertuje sie na Result (tak jak std::function).
+	template <typename F, typename Functor = std::decay_t<F>,
+	          typename = std::enable_if_t<!std::is_same<Functor, inplace_function>::value &&
+	                                      !std::is_member_pointer<Functor>::value &&
+	                                      std::is_invocable_r<Result, Functor&, Args...>::value>>
+	inplace_function(F&& f) : inplace_function()
+	{
+		static_assert(sizeof(Functor) <= Capacity, "Functor does not fit in inplace_function - increase Capacity.");
+		static_assert(Align % alignof(Functor) == 0, "Functor alignment is not supported by inplace_function - increase Align.");
+		static_assert(std::is_copy_constructible<Functor>::value, "Functor has to be copy constructible.");
+		static_assert(std::is_nothrow_move_constructible<Functor>::value, "Functor has to be nothrow move constructible.");
+
+		if constexpr (std::is_pointer<std::remove_reference_t<F>>::value)
+			if (f == nullptr)
+				return;
+
+		new (&storage_) Functor(std::forward<F>(f));
+		invoke_ = Impl::inplace_ops<Functor, Result, Args...>::vtable.invoke;
+		vtable_ = &Impl::inplace_ops<Functor, Result, Args...>::vtable;
+	}
+
+	inplace_function(const inplace_function& other) : invoke_(other.invoke_), vtable_(other.vtable_)
+	{ vtable_->copy(&storage_, &other.storage_); }
+
+	inplace_function(inplace_function&& other) noexcept : invoke_(other.invoke_), vtable_(other.vtable_)
+	{ vtable_->move(&storage_, &other.storage_); }
+
+	// Kopia powstaje najpierw obok - jesli konstruktor kopiujacy funktora rzuci *this zostaje bez zmian.
+	inplace_function& operator=(const inplace_function& other)
+	{
+		if (this != std::addressof(other))
+			*this = inplace_function(other);
+		return *this;
+	}
+
+	inplace_function& operator=(inplace_function&& other) noexcept
+	{
+		if (this != std::addressof(other))
+		{
+			vtable_->destroy(&storage_);
+			invoke_ = Impl::inplace_empty<Result, Args...>::vtable.invoke;
+			vtable_ = &Impl::inplace_empty<Result, Args...>::vtable;
+			other.vtable_->move(&storage_, &other.storage_);
+			invoke_ = other.invoke_;
+			vtable_ = other.vtable_;
+		}
+		return *this;
+	}
+
+	~inplace_function() { vtable_->destroy(&storage_); }
+
+	Result operator()(Args... args) const
+	{ return invoke_(&storage_, std::forward<Args>(args)...); }
+
+	explicit operator bool() const noexcept
+	{ return vtable_ != &Impl::inplace_empty<Result, Args...>::vtable; }
+
+	static constexpr size_t capacity() { return Capacity; }
+
+private:
+	mutable std::aligned_storage_t<Capacity, Align> storage_;
+	Result (*invoke_)(void*, Args&&...);
+	const vtable_type* vtable_;
+};
+
+template <typename F>
+inplace_function(F) -> inplace_function<typename function_traits<F>::type_signature>;
+
+
+
+// ----------- MAPY O ZAMKNIETYM ZBIORZE KLUCZY BEDACYCH TYPAMI -----------//
+
+// Stabilny (taki sam w kazdej jednostce kompilacji i przy kazdym uruchomieniu) identyfikator typu
+// liczony w trakcie kompilacji jako hash FNV-1a z nazwy funkcji zawierajacej nazwe typu.
+// Nie wymaga RTTI. Wartosc zalezy od kompilatora wiec nie nalezy jej zapisywac do plikow.
+// Przyklad uzycia: constexpr type_id_t id = type_id<int>();
+using type_id_t = std::uint64_t;
+
+template <typename T>
+constexpr type_id_t type_id()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	const char* name = __FUNCSIG__;
+#else
+	const char* name = __PRETTY_FUNCTION__;
+#endif
+	type_id_t hash = 14695981039346656037ull;
+	for (; *name != '\0'; ++name)
+	{
+		hash ^= static_cast<unsigned char>(*name);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+
+
+// Idealny hash (bez kolizji) dla N znanych w trakcie kompilacji identyfikatorow, budowany metoda
+// "hash and displace": identyfikator trafia najpierw do kubelka, a kazdy kubelek ma wlasne ziarno
+// (displacement) dobrane tak by jego identyfikatory trafily w wolne sloty. Wyszukiwanie to zawsze
+// dwa hashe i jedno porownanie. Zwraca index identyfikatora lub N jesli go nie ma.
+// Przyklad uzycia: constexpr auto h = Impl::make_perfect_hash<2>({ type_id<int>(), type_id<char>() });
+namespace Impl
+{
+	constexpr type_id_t perfect_hash_mix(type_id_t id, type_id_t seed)
+	{
+		type_id_t x = id ^ (seed * 0x9E3779B97F4A7C15ull);
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+		return x ^ (x >> 31);
+	}
+
+	constexpr size_t perfect_hash_slots(size_t count)
+	{
+		size_t slots = 1u;
+		while (slots < count)
+			slots *= 2u;
+		return slots * 2u;
+	}
+
+	template <size_t N>
+	struct perfect_hash
+	{
+		static constexpr size_t slots = perfect_hash_slots(N);
+
+		std::array<type_id_t, slots> displacement{};
+		std::array<type_id_t, slots> slot_id{};
+		std::array<size_t, slots>    slot_index{};
+		bool                         valid = true;
+
+		constexpr size_t find(type_id_t id) const
+		{
+			const size_t bucket = perfect_hash_mix(id, 0u) & (slots - 1u);
+			const size_t slot   = perfect_hash_mix(id, displacement[bucket]) & (slots - 1u);
+			return (slot_index[slot] != N && slot_id[slot] == id) ? slot_index[slot] : N;
+		}
+	};
+
+	template <size_t N>
+	constexpr perfect_hash<N> make_perfect_hash(const std::array<type_id_t, N>& ids)
+	{
+		constexpr size_t slots = perfect_hash<N>::slots;
+		perfect_hash<N> hash{};
+		for (size_t s = 0u; s < slots; ++s)
+			hash.slot_index[s] = N;
+
+		std::array<size_t, N>     bucket_of{};
+		std::array<size_t, slots> bucket_size{};
+		for (size_t i = 0u; i < N; ++i)
+		{
+			bucket_of[i] = perfect_hash_mix(ids[i], 0u) & (slots - 1u);
+			++bucket_size[bucket_of[i]];
+		}
+
+		// Kubelki sa rozmieszczane od najwiekszego - im mniej wolnych slotow tym latwiej o sukces dla malych.
+		for (size_t placed = 0u; placed < N; )
+		{
+			size_t bucket = 0u;
+			for (size_t b = 1u; b < slots; ++b)
+				bucket = (bucket_size[b] > bucket_size[bucket]) ? b : bucket;
+
+			bool fits = false;
+			type_id_t seed = 1u;
+			for (; !fits && seed < (1u << 16); ++seed)
+			{
+				fits = true;
+				for (size_t i = 0u; i < N; ++i)
+				{
+					if (bucket_of[i] != bucket)
+						continue;
+					const size_t slot = perfect_hash_mix(ids[i], seed) & (slots - 1u);
+					if (hash.slot_index[slot] != N)
+					{
+						fits = false;
+						break;
+					}
+					hash.slot_index[slot] = i;
+					hash.slot_id[slot] = ids[i];
+				}
+				// Cofniecie czesciowo rozmieszczonego kubelka przed sprawdzeniem kolejnego ziarna.
+				for (size_t s = 0u; !fits && s < slots; ++s)
+					if (hash.slot_index[s] != N && bucket_of[hash.slot_index[s]] == bucket)
+						hash.slot_index[s] = N;
+			}
+			if (!fits)
+			{
+				hash.valid = false;
+				return hash;
+			}
+			hash.displacement[bucket] = seed - 1u;
+			placed += bucket_size[bucket];
+			bucket_size[bucket] = 0u;
+		}
+		return hash;
+	}
+}
+
+
+
+// Mapa w ktorej kluczami sa typy z paczki typow a wartosciami obiekty typu V. Zamiast
+// std::unordered_map<std::type_index, V> wartosci sa trzymane w jednej tablicy std::array<V, N>:
+// get<K>() to zwykly odczyt z tablicy pod indexem wyliczonym w trakcie kompilacji (index_of),
+// a wyszukiwanie w trakcie dzialania programu po indexie lub po stabilnym identyfikatorze
+// (type_id<K>()) idzie przez idealny hash bez kolizji i bez RTTI. Klucze musza byc unikalne.
+// Przyklad uzycia: type_map<TypePack<int, float>, size_t> counters;
+//                  counters.get<float>() += 1;
+//                  counters.find(type_id<float>()); // <--- wskaznik na ta sama wartosc
+//                  counters.for_each([](auto key_obj, size_t& v){ v = sizeof(typename decltype(key_obj)::type); });
+template <typename Keys, typename V>
+class type_map;
+
+template <typename... Ks, typename V>
+class type_map<TypePack<Ks...>, V>
+{
+	static_assert(contains_unique<Ks...>(), "Keys of type_map have to be unique.");
+
+	static constexpr Impl::perfect_hash<sizeof...(Ks)> hash_ = Impl::make_perfect_hash<sizeof...(Ks)>({{ type_id<Ks>()... }});
+	static_assert(hash_.valid, "Couldn't build perfect hash for type_map keys (type_id collision?).");
+
+public:
+	using keys       = TypePack<Ks...>;
+	using value_type = V;
+
+	static constexpr size_t npos = sizeof...(Ks);
+
+	static constexpr size_t size() { return sizeof...(Ks); }
+
+	// Index klucza o podanym identyfikatorze lub npos jesli takiego klucza nie ma.
+	static constexpr size_t index_of_id(type_id_t id) { return hash_.find(id); }
+
+	template <typename K> V&       get()       { return values_[tpack::index_of<K, Ks...>::value]; }
+	template <typename K> const V& get() const { return values_[tpack::index_of<K, Ks...>::value]; }
+
+	V&       operator[](size_t index)       { return values_[index]; }
+	const V& operator[](size_t index) const { return values_[index]; }
+
+	V* find(type_id_t id)
+	{
+		const size_t index = index_of_id(id);
+		return index != npos ? &values_[index] : nullptr;
+	}
+	const V* find(type_id_t id) const
+	{
+		const size_t index = index_of_id(id);
+		return index != npos ? &values_[index] : nullptr;
+	}
+
+	// Do funkcji zostana wyslane: obiekt w ktory jest zapakowany typ klucza (TypeWrapper) oraz wartosc.
+	template <typename Function>
+	void for_each(Function&& f)
+	{
+		size_t index = 0;
+		using Swallow = int[];
+		(void)Swallow{0, (void( f(TypeWrapper<Ks>(), values_[index++]) ), 0)... };
+	}
+	template <typename Function>
+	void for_each(Function&& f) const
+	{
+		size_t index = 0;
+		using Swallow = int[];
+		(void)Swallow{0, (void( f(TypeWrapper<Ks>(), values_[index++]) ), 0)... };
+	}
+
+	std::array<V, sizeof...(Ks)>&       values()       { return values_; }
+	const std::array<V, sizeof...(Ks)>& values() const { return values_; }
+
+private:
+	std::array<V, sizeof...(Ks)> values_{};
+};
+
+
+
+// Wariant type_map w ktorym kazdy klucz ma wlasny typ wartosci: F<K>::type (tak jak w modify).
+// Wartosci sa trzymane w std::tuple, a get<K>() to std::get pod indexem wyliczonym w trakcie kompilacji.
+// Przyklad uzycia: template<typename T> struct PoolOf { using type = std::vector<T>; };
+//                  hetero_type_map<TypePack<int, float>, PoolOf> pools;
+//                  pools.get<float>().push_back(1.f);
+template <typename Keys, template<typename> typename F>
+class hetero_type_map;
+
+template <typename... Ks, template<typename> typename F>
+class hetero_type_map<TypePack<Ks...>, F>
+{
+	static_assert(contains_unique<Ks...>(), "Keys of hetero_type_map have to be unique.");
+
+	static constexpr Impl::perfect_hash<sizeof...(Ks)> hash_ = Impl::make_perfect_hash<sizeof...(Ks)>({{ type_id<Ks>()... }});
+	static_assert(hash_.valid, "Couldn't build perfect hash for hetero_type_map keys (type_id collision?).");
+
+public:
+	using keys        = TypePack<Ks...>;
+	using value_types = TypePack<typename F<Ks>::type...>;
+
+	static constexpr size_t npos = sizeof...(Ks);
+
+	static constexpr size_t size() { return sizeof...(Ks); }
+
+	static constexpr size_t index_of_id(type_id_t id) { return hash_.find(id); }
+
+	template <typename K> typename F<K>::type&       get()       { return std::get<tpack::index_of<K, Ks...>::value>(values_); }
+	template <typename K> const typename F<K>::type& get() const { return std::get<tpack::index_of<K, Ks...>::value>(values_); }
+
+	// Do funkcji zostana wyslane: obiekt w ktory jest zapakowany typ klucza (TypeWrapper) oraz wartosc.
+	template <typename Function>
+	void for_each(Function&& f)
+	{
+		for_each(f, std::index_sequence_for<Ks...>{});
+	}
+	template <typename Function>
+	void for_each(Function&& f) const
+	{
+		for_each(f, std::index_sequence_for<Ks...>{});
+	}
+
+private:
+	template <typename Function, size_t... Is>
+	void for_each(Function& f, std::index_sequence<Is...>)
+	{
+		using Swallow = int[];
+		(void)Swallow{0, (void( f(TypeWrapper<Ks>(), std::get<Is>(values_)) ), 0)... };
+	}
+	template <typename Function, size_t... Is>
+	void for_each(Function& f, std::index_sequence<Is...>) const
+	{
+		using Swallow = int[];
+		(void)Swallow{0, (void( f(TypeWrapper<Ks>(), std::get<Is>(values_)) ), 0)... };
+	}
+
+	std::tuple<typename F<Ks>::type...> values_{};
+};
+
+
+
+// ----------- BUFOR POLECEN ROZNYCH TYPOW W JEDNYM CIAGLYM OBSZARZE PAMIECI -----------//
+
+// Bufor polecen (obiektow typow z paczki) zapisywanych jedno za drugim w jednym ciaglym obszarze pamieci.
+// Kazde polecenie jest poprzedzone naglowkiem: znacznikiem typu (index_of w paczce) oraz przesunieciem do
+// kolejnego naglowka spakowanymi w jedno slowo 16 bitowe (gdy zmieszcza sie w nim wszystkie polecenia)
+// lub 32 bitowe. Polecenie lezy zaraz za naglowkiem
+// pod adresem spelniajacym jego align. Dodanie polecenia to zwykle przesuniecie wskaznika konca (bez
+// alokacji dopoki starcza pojemnosci), a replay(visitor) przechodzi bufor liniowo i wywoluje visitor(cmd)
+// przez tablice funkcji indeksowana znacznikiem (bez funkcji wirtualnych). reset() niszczy polecenia
+// ale zostawia pamiec do ponownego uzycia - polecenia trywialnie destruowalne nie sa nawet odwiedzane.
+// Polecenia musza miec konstruktory przenoszace noexcept (lub byc is_trivially_relocatable) - powiekszenie
+// bufora przenosi je i nie moze zostac przerwane w polowie.
+// Przyklad uzycia: command_buffer<TypePack<Draw, Clear>> commands;
+//                  commands.emplace<Clear>(0xff000000u);
+//                  commands.push(Draw{ mesh, 3u });
+//                  commands.replay([&](auto& cmd){ execute(cmd); });
+//                  commands.reset();
+template<typename Commands>
+class command_buffer;
+
+namespace Impl
+{
+	// Ilosc bitow potrzebna do zapisania liczby value.
+	constexpr unsigned bit_width(size_t value)
+	{
+		unsigned bits = 0u;
+		for (; value; value >>= 1u)
+			++bits;
+		return bits;
+	}
+
+	// Najwiekszy sizeof + alignof sposrod polecen - ogranicza przesuniecie miedzy naglowkami.
+	template<typename... Cmds>
+	constexpr size_t command_max_record()
+	{
+		size_t record = 0u;
+		using Swallow = int[];
+		(void)Swallow{0, (void( record = sizeof(Cmds) + alignof(Cmds) > record ? sizeof(Cmds) + alignof(Cmds) : record ), 0)... };
+		return record;
+	}
+
+	// Naglowek polecenia: w mlodszych tag_bits bitach znacznik typu, w pozostalych przesuniecie w bajtach
+	// od poczatku tego naglowka do kolejnego. Slowo jest 16 bitowe gdy zmiesci najwieksze mozliwe przesuniecie
+	// (max_record - command_max_record), inaczej 32 bitowe.
+	template<size_t count, size_t max_record>
+	struct command_header
+	{
+		static constexpr unsigned tag_bits  = bit_width(count - 1u);
+		static constexpr unsigned next_bits = bit_width(max_record + 2u * sizeof(std::uint32_t));
+
+		static_assert(tag_bits + next_bits <= 32u, "Command type is too big for command_buffer.");
+		using word = typename std::conditional<(tag_bits + next_bits <= 16u), std::uint16_t, std::uint32_t>::type;
+
+		constexpr command_header(size_t tag, size_t next) : bits(static_cast<word>(tag | (next << tag_bits))) {}
+
+		constexpr size_t tag()  const { return bits & ((size_t(1) << tag_bits) - 1u); }
+		constexpr size_t next() const { return bits >> tag_bits; }
+
+		word bits;
+	};
+
+	constexpr size_t align_up(size_t offset, size_t align)
+	{
+		return (offset + align - 1u) / align * align;
+	}
+
+	// Adres polecenia typu T lezacego za naglowkiem pod adresem header.
+	template<typename T, typename Header>
+	T* command_at(unsigned char* header)
+	{
+		const size_t offset = align_up(reinterpret_cast<std::uintptr_t>(header) + sizeof(Header), alignof(T)) - reinterpret_cast<std::uintptr_t>(header);
+		return std::launder(reinterpret_cast<T*>(header + offset));
+	}
+
+	template<typename T, typename Header, typename Visitor>
+	void command_visit(Visitor& visitor, unsigned char* header)
+	{
+		visitor(*command_at<T, Header>(header));
+	}
+
+	template<typename T, typename Header>
+	void command_destroy(unsigned char* header)
+	{
+		command_at<T, Header>(header)->~T();
+	}
+
+	template<typename T, typename Header>
+	void command_relocate(unsigned char* dst_header, unsigned char* src_header)
+	{
+		T* src = command_at<T, Header>(src_header);
+		new (command_at<T, Header>(dst_header)) T(std::move(*src));
+		src->~T();
+	}
+}
+
+template<typename... Cmds>
+class command_buffer<TypePack<Cmds...>>
+{
+	static_assert(sizeof...(Cmds) > 0u, "command_buffer needs at least one command type.");
+	static_assert(contains_unique<Cmds...>(), "Command types have to be unique.");
+
+	using header = Impl::command_header<sizeof...(Cmds), Impl::command_max_record<Cmds...>()>;
+
+	static constexpr size_t alignment = max_alignof<header, Cmds...>();
+
+	static constexpr bool trivially_destructible = check_all<std::is_trivially_destructible, Cmds...>();
+	static constexpr bool trivially_relocatable  = check_all<is_trivially_relocatable, Cmds...>();
+
+public:
+	using commands = TypePack<Cmds...>;
+
+	command_buffer() = default;
+	explicit command_buffer(size_t bytes) { reserve(bytes); }
+
+	command_buffer(const command_buffer&) = delete;
+	command_buffer& operator=(const command_buffer&) = delete;
+
+	command_buffer(command_buffer&& other) noexcept
+		: data_(other.data_), size_(other.size_), capacity_(other.capacity_), count_(other.count_)
+	{
+		other.data_ = nullptr;
+		other.size_ = other.capacity_ = other.count_ = 0u;
+	}
+
+	command_buffer& operator=(command_buffer&& other) noexcept
+	{
+		if (this != &other)
+		{
+			release();
+			data_     = other.data_;
+			size_     = other.size_;
+			capacity_ = other.capacity_;
+			count_    = other.count_;
+			other.data_ = nullptr;
+			other.size_ = other.capacity_ = other.count_ = 0u;
+		}
+		return *this;
+	}
+
+	~command_buffer() { release(); }
+
+	// Tworzy polecenie typu Cmd (z podanych argumentow, agregaty przez {}) na koncu bufora i zwraca referencje do niego.
+	// Gdy trzeba powiekszyc bufor nowe polecenie jest tworzone w nowym obszarze zanim zostana do niego przeniesione
+	// stare (jak w std::vector::emplace_back) - argumenty moga wiec byc referencjami do polecen z tego bufora.
+	// Jesli konstruktor rzuci wyjatek bufor zostaje bez zmian.
+	template<typename Cmd, typename... Args>
+	Cmd& emplace(Args&&... args)
+	{
+		static_assert(contains<Cmd, Cmds...>(), "Cmd is not one of command_buffer command types.");
+
+		const size_t header_offset  = Impl::align_up(size_, alignof(header));
+		const size_t command_offset = Impl::align_up(header_offset + sizeof(header), alignof(Cmd));
+		const size_t end            = Impl::align_up(command_offset + sizeof(Cmd), alignof(header));
+
+		unsigned char* data     = data_;
+		size_t         capacity = capacity_;
+		if (end > capacity_)
+		{
+			capacity = grown_capacity(end);
+			data     = allocate(capacity);
+		}
+
+		Cmd* command = nullptr;
+		try
+		{
+			if constexpr (std::is_constructible<Cmd, Args...>::value)
+				command = new (data + command_offset) Cmd(std::forward<Args>(args)...);
+			else
+				command = new (data + command_offset) Cmd{ std::forward<Args>(args)... };
+		}
+		catch (...)
+		{
+			if (data != data_)
+				deallocate(data);
+			throw;
+		}
+		if (data != data_)
+			adopt(data, capacity);
+		new (data_ + header_offset) header(tpack::index_of<Cmd, Cmds...>::value, end - header_offset);
+		size_ = end;
+		++count_;
+		return *command;
+	}
+
+	// Kopiuje lub przenosi gotowe polecenie na koniec bufora.
+	template<typename Cmd>
+	std::decay_t<Cmd>& push(Cmd&& command)
+	{
+		return emplace<std::decay_t<Cmd>>(std::forward<Cmd>(command));
+	}
+
+	// Wywoluje visitor(cmd) dla kazdego polecenia w kolejnosci dodania.
+	template<typename Visitor>
+	void replay(Visitor&& visitor)
+	{
+		using Function = void(*)(Visitor&, unsigned char*);
+		static constexpr Function table[] = { &Impl::command_visit<Cmds, header, Visitor>... };
+
+		for (size_t offset = 0u; offset < size_; )
+		{
+			unsigned char* position = data_ + offset;
+			const header* h = std::launder(reinterpret_cast<const header*>(position));
+			offset += h->next();
+			table[h->tag()](visitor, position);
+		}
+	}
+
+	// Niszczy wszystkie polecenia ale zostawia zaalokowana pamiec.
+	void reset()
+	{
+		if constexpr (!trivially_destructible)
+			for_each_header(destroy_table());
+		size_  = 0u;
+		count_ = 0u;
+	}
+
+	void reserve(size_t bytes)
+	{
+		if (bytes > capacity_)
+			reallocate(bytes);
+	}
+
+	size_t size()     const { return count_; }
+	size_t bytes()    const { return size_; }
+	size_t capacity() const { return capacity_; }
+	bool   empty()    const { return count_ == 0u; }
+
+private:
+	using Destroy  = void(*)(unsigned char*);
+	using Relocate = void(*)(unsigned char*, unsigned char*);
+
+	// Dla polecen trywialnie destruowalnych w tablicy jest nullptr - nie trzeba ich odwiedzac.
+	static const Destroy* destroy_table()
+	{
+		static constexpr Destroy table[] = { (std::is_trivially_destructible<Cmds>::value ? nullptr : &Impl::command_destroy<Cmds, header>)... };
+		return table;
+	}
+
+	void for_each_header(const Destroy* table)
+	{
+		for (size_t offset = 0u; offset < size_; )
+		{
+			unsigned char* position = data_ + offset;
+			const header* h = std::launder(reinterpret_cast<const header*>(position));
+			offset += h->next();
+			if (table[h->tag()])
+				table[h->tag()](position);
+		}
+	}
+
+	size_t grown_capacity(size_t required) const
+	{
+		size_t capacity = capacity_ ? capacity_ * 2u : 256u;
+		while (capacity < required)
+			capacity *= 2u;
+		return capacity;
+	}
+
+	static unsigned char* allocate(size_t capacity)
+	{
+		return static_cast<unsigned char*>(::operator new(capacity, std::align_val_t(alignment)));
+	}
+
+	static void deallocate(unsigned char* data)
+	{
+		::operator delete(data, std::align_val_t(alignment));
+	}
+
+	void reallocate(size_t capacity)
+	{
+		adopt(allocate(capacity), capacity);
+	}
+
+	// Przenosi polecenia do nowego obszaru i zwalnia stary. Przesuniecia sa zachowane bo oba obszary maja
+	// ten sam align. Przenoszenie nie moze rzucic wyjatku (memcpy lub konstruktory przenoszace noexcept).
+	void adopt(unsigned char* data, size_t capacity) noexcept
+	{
+		if constexpr (trivially_relocatable)
+		{
+			if (size_)
+				std::memcpy(data, data_, size_);
+		}
+		else
+		{
+			static_assert(check_all<std::is_nothrow_move_constructible, Cmds...>(),
+				"command_buffer needs nothrow move constructors or is_trivially_relocatable command types.");
+			static constexpr Relocate table[] = { &Impl::command_relocate<Cmds, header>... };
+			for (size_t offset = 0u; offset < size_; )
+			{
+				const header* h = std::launder(reinterpret_cast<const header*>(data_ + offset));
+				new (data + offset) header(*h);
+				table[h->tag()](data + offset, data_ + offset);
+				offset += h->next();
+			}
+		}
+		if (data_)
+			deallocate(data_);
+		data_     = data;
+		capacity_ = capacity;
+	}
+
+	void release()
+	{
+		reset();
+		if (data_)
+			deallocate(data_);
+		data_     = nullptr;
+		capacity_ = 0u;
+	}
+
+	unsigned char* data_     = nullptr;
+	size_t         size_     = 0u; // ilosc zajetych bajtow
+	size_t         capacity_ = 0u;
+	size_t         count_    = 0u; // ilosc polecen
 };
 
 
@@ -737,11 +1807,14 @@ struct TypePack final
 
     using remove_repetitions = typename tpack::remove_repetitions<Us...>::type;
 
-	using underlying_types = typename
-		modify<std::remove_reference>::template
-		modify<std::remove_cv>::template
-		modify<std::remove_pointer>::template
-		modify<std::remove_all_extents>;
+	template<typename... Stages>
+	using pipe = typename tpack::pipe<TypePack<Us...>, Stages...>::type;
+
+	using underlying_types = pipe<
+		stage::modify<std::remove_reference>,
+		stage::modify<std::remove_cv>,
+		stage::modify<std::remove_pointer>,
+		stage::modify<std::remove_all_extents>>;
 
     //Przyklad uzycia 1  : TypePack<>::append<int, TypePack<char, float>>        // zwroci typ TypePack<int,char,float>
     //Przyklad uzycia 2  : TypePack<TypePack<int>>::append<TypePack<int>>        // zwroci typ TypePack<TypePack<int>, int>
@@ -753,6 +1826,7 @@ struct TypePack final
 	//Przyklad uzycia 8  : TypePack<const int, int*, int&&>::underlying_types	 // zwroci typ TypePack<int,int,int>
 	//Przyklad uzycia 9  : TypePack<int,char,float>::remove_back<2>		         // zwroci typ TypePack<int>
 	//Przyklad uzycia 10 : TypePack<int, long, char, float, void>::divide<2>	 // zwroci typ TypePack<TypePack<int, long>, TypePack<char, float>, TypePack<void>>
+	//Przyklad uzycia 11 : TypePack<int,float,int,char>::pipe<stage::remove_repetitions, stage::take<2>> // zwroci typ TypePack<int,float>
 
 
 
@@ -761,7 +1835,7 @@ struct TypePack final
 	template<typename Function>
 	static void for_each_type(Function&& f)
 	{
-		::for_each_type<Us...>(std::forward<Function>(f));
+		tpack::for_each_type<Us...>(std::forward<Function>(f));
 	}
 
 	//Przyklad uzycia 1 : TypePack<int,char>
@@ -774,6 +1848,22 @@ struct TypePack final
     //Odpowiednia zaalokowana pamiec na typy.
     using aligned_storage = tpack::aligned_storage<Us...>;
 
+	template<size_t Index> using aligned_offset = std::integral_constant<size_t, tpack::aligned_offset<Index, Us...>()>;
+
+	//Cechy liczone dopiero przy uzyciu (szablony) - specjalizacje is_trivially_relocatable moga byc dodane po uzyciu paczki.
+	template<typename = void> static constexpr bool is_trivially_relocatable()  { return tpack::check_all<tpack::is_trivially_relocatable, Us...>(); }
+	template<typename = void> static constexpr bool is_trivially_copyable()     { return tpack::check_all<std::is_trivially_copyable, Us...>(); }
+	template<typename = void> static constexpr bool is_trivially_destructible() { return tpack::check_all<std::is_trivially_destructible, Us...>(); }
+
+	//Operacje na tablicach rekordow aligned_storage (jedno memcpy / memset lub nic gdy pozwalaja na to cechy paczki).
+	static void uninitialized_construct_n(aligned_storage* records, size_t count) { tpack::uninitialized_construct_n<Us...>(records, count); }
+	static void destroy_n(aligned_storage* records, size_t count)                 { tpack::destroy_n<Us...>(records, count); }
+	static void relocate_n(aligned_storage* src, size_t count, aligned_storage* dst) { tpack::relocate_n<Us...>(src, count, dst); }
+
+	//Przyklad uzycia 1 : TypePack<char,short,float>::aligned_offset<2>()         // 4 bo 1 + 1p + 2
+	//Przyklad uzycia 2 : TypePack<int,std::string>::is_trivially_relocatable()  // 0 bo std::string nie jest trywialnie kopiowalny
+	//Przyklad uzycia 3 : pack::relocate_n(old_records, size, new_records)        // przeniesienie rekordow przy zmianie rozmiaru tablicy
+
 
    //------------------ FUNKCJA WYPISUJACA POZWALAJACA NA DEBUGOWANIE -------------------//
 
@@ -843,5 +1933,89 @@ using Components  = UsedStructs::filter_inv<std::is_empty>;
 using Tags        = UsedStructs::filter<std::is_empty>;
 static_assert(std::is_same<Components, TypePack<Component1, Component2, Component3, Component4>>::value, "FAIL");
 static_assert(std::is_same<Tags, TypePack<Tag1, Tag2, Tag3, Tag4>>::value, "FAIL");
+
+
+//Testy potokow (pipe).
+using PipedComponents = Structs::pipe<stage::remove_repetitions, stage::filter_inv<std::is_empty>>;
+using PipedTags       = Structs::pipe<stage::filter<std::is_empty>, stage::remove_repetitions, stage::take<3>>;
+static_assert(std::is_same<PipedComponents, Components>::value, "FAIL");
+static_assert(std::is_same<PipedTags, TypePack<Tag1, Tag2, Tag3>>::value, "FAIL");
+static_assert(std::is_same<TypePack<const int, int*, int&&, const int[2]>::underlying_types, TypePack<int, int, int, int>>::value, "FAIL");
+static_assert(std::is_same<TypePack<int, const int>::pipe<stage::modify<std::remove_const>, stage::remove_repetitions>, TypePack<int>>::value, "FAIL");
+static_assert(std::is_same<TypePack<int, char>::pipe<>, TypePack<int, char>>::value, "FAIL");
+
+
+//Testy function_traits oraz dedukcji sygnatury inplace_function.
+struct Functor1 { long operator()(char, float) const noexcept { return 0; } };
+struct Functor2 { void operator()(int) && {} };
+static_assert(std::is_same<function_traits<Functor1>::type_signature, long(char, float)>::value, "FAIL");
+static_assert(function_traits<Functor1>::is_noexcept, "FAIL");
+static_assert(std::is_same<function_traits<Functor2>::type_pack_args, TypePack<int>>::value, "FAIL");
+static_assert(!function_traits<Functor2>::is_noexcept, "FAIL");
+static_assert(std::is_same<function_traits<int(*)(double) noexcept>::type_result, int>::value, "FAIL");
+static_assert(std::is_same<decltype(inplace_function(Functor1())), inplace_function<long(char, float)>>::value, "FAIL");
+static_assert(std::is_convertible<Functor1, inplace_function<void(int, int)>>::value, "FAIL");
+static_assert(!std::is_convertible<Functor1, inplace_function<long(int*)>>::value, "FAIL");
+static_assert(!std::is_convertible<Functor1, inplace_function<int*(char, float)>>::value, "FAIL");
+static_assert(std::is_nothrow_move_constructible<inplace_function<void()>>::value, "FAIL");
+static_assert(std::is_nothrow_move_assignable<inplace_function<void()>>::value, "FAIL");
+//Wynik funktora jest odrzucany gdy sygnatura zwraca void - wystarczy ze sie skompiluje.
+inline void inplace_function_discards_result()
+{
+	inplace_function<void(int, int)> f = Functor1();
+	f(1, 2);
+}
+
+
+//Testy naglowka command_buffer.
+struct SetColor4 { std::uint32_t color; };
+static_assert(sizeof(Impl::command_header<4, Impl::command_max_record<SetColor4, double>()>) == 2, "FAIL");
+static_assert(sizeof(Impl::command_header<4, 70000u>) == 4, "FAIL");
+static_assert(Impl::command_header<5, 100u>(4u, 60u).tag() == 4u && Impl::command_header<5, 100u>(4u, 60u).next() == 60u, "FAIL");
+static_assert(Impl::command_header<1, 100u>(0u, 60u).tag() == 0u && Impl::command_header<1, 100u>(0u, 60u).next() == 60u, "FAIL");
+
+
+//Testy type_map.
+using ComponentMap = type_map<Components, int>;
+static_assert(ComponentMap::index_of_id(type_id<Component3>()) == 2, "FAIL");
+static_assert(ComponentMap::index_of_id(type_id<Tag1>()) == ComponentMap::npos, "FAIL");
+static_assert(type_map<TypePack<>, int>::index_of_id(type_id<int>()) == 0, "FAIL");
+
+template<typename T> struct PointerTo { using type = T*; };
+using PointerMap = hetero_type_map<TypePack<int, char>, PointerTo>;
+static_assert(std::is_same<PointerMap::value_types, TypePack<int*, char*>>::value, "FAIL");
+//Przejscie po stalej mapie - wystarczy ze sie skompiluje.
+inline size_t count_null_pointers(const PointerMap& map)
+{
+	size_t count = 0u;
+	map.for_each([&](auto, auto* const& value){ count += value == nullptr; });
+	return count;
+}
+
+
+//Testy cech calej paczki i offsetow w aligned_storage.
+struct Relocatable { Relocatable(Relocatable&&) {} ~Relocatable() {} };
+}
+template<> struct is_trivially_relocatable<_compile_time_tests::Relocatable> : std::true_type {};
+namespace _compile_time_tests
+{
+static_assert(TypePack<char, short, float>::aligned_offset<2>() == 4, "FAIL");
+static_assert(TypePack<char, double, char>::aligned_offset<2>() == 16, "FAIL");
+static_assert(pack::is_trivially_relocatable() && pack::is_trivially_copyable() && pack::is_trivially_destructible(), "FAIL");
+static_assert(TypePack<int, Relocatable>::is_trivially_relocatable() == true, "FAIL");
+static_assert(TypePack<int, Relocatable>::is_trivially_copyable() == false, "FAIL");
+static_assert(TypePack<int, Relocatable>::is_trivially_destructible() == false, "FAIL");
+
+//Specjalizacja is_trivially_relocatable po uzyciu paczki (cechy paczki sa liczone leniwie).
+struct LateRelocatable { LateRelocatable(LateRelocatable&&) = delete; ~LateRelocatable() {} };
+using LateRecord = TypePack<int, LateRelocatable>;
+static_assert(LateRecord::size() == 2, "FAIL");
+}
+template<> struct is_trivially_relocatable<_compile_time_tests::LateRelocatable> : std::true_type {};
+namespace _compile_time_tests
+{
+static_assert(LateRecord::is_trivially_relocatable(), "FAIL");
+//Dla paczki relokowalnej nie jest potrzebny konstruktor przenoszacy (memcpy zamiast przenoszenia obiektow).
+constexpr void (*relocate_late)(LateRecord::aligned_storage*, size_t, LateRecord::aligned_storage*) = &relocate_n<int, LateRelocatable>;
+}
 }
-}
\ No newline at end of file
@@ -0,0 +1,506 @@
+// Autor: Aron Mandrella
+
+#pragma once
+#include "TypePack.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tpack
+{
+
+
+namespace Impl
+{
+	// Pojemnosc kolejki spsc_ring - najmniejsza potega dwojki (>= 2) nie mniejsza niz podana.
+	constexpr size_t spsc_capacity(size_t capacity)
+	{
+		size_t result = 2u;
+		while (result < capacity)
+			result *= 2u;
+		return result;
+	}
+}
+
+// --------- KOLEJKA JEDEN PRODUCENT / JEDEN KONSUMENT BEZ BLOKAD ---------//
+
+// Ograniczona kolejka bez blokad (lock-free) dla dokladnie jednego watku zapisujacego i jednego
+// czytajacego. Pojemnosc jest zaokraglana w gore do potegi dwojki. Elementy sa przekazywane
+// paczkami (push_batch / pop_batch) by na jedna operacje atomowa przypadalo wiele elementow.
+// Producent po ostatnim elemencie wywoluje close(), a konsument konczy gdy finished() == true.
+// Czekanie na miejsce lub dane (wait) najpierw chwile kreci sie w petli, a potem usypia watek - bezczynny
+// potok nie zajmuje rdzeni. Budzenie kosztuje tylko sprawdzenie licznika spiacych gdy nikt nie czeka.
+// Uwaga: typ T musi miec konstruktor domyslny (bufor jest tworzony z gory).
+// Przyklad uzycia: spsc_ring<int> ring(1024); ring.push_batch(items, 16); ring.pop_batch(out, 16);
+template<typename T>
+class spsc_ring
+{
+public:
+	explicit spsc_ring(size_t capacity) : buffer_(Impl::spsc_capacity(capacity)), mask_(buffer_.size() - 1u) {}
+
+	spsc_ring(const spsc_ring&) = delete;
+	spsc_ring& operator=(const spsc_ring&) = delete;
+
+	// Przenosi do kolejki tyle elementow ile sie zmiesci (najwyzej count) i zwraca ich ilosc.
+	size_t push_batch(T* items, size_t count)
+	{
+		const size_t tail = tail_.load(std::memory_order_relaxed);
+		if (cached_head_ + buffer_.size() - tail < count)
+			cached_head_ = head_.load(std::memory_order_acquire);
+
+		const size_t free  = cached_head_ + buffer_.size() - tail;
+		const size_t moved = count < free ? count : free;
+		for (size_t i = 0u; i < moved; ++i)
+			buffer_[(tail + i) & mask_] = std::move(items[i]);
+
+		tail_.store(tail + moved, std::memory_order_release);
+		if (moved != 0u)
+			wake_sleepers();
+		return moved;
+	}
+
+	// Wyciaga z kolejki najwyzej count elementow i zwraca ich ilosc.
+	size_t pop_batch(T* items, size_t count)
+	{
+		const size_t head = head_.load(std::memory_order_relaxed);
+		if (cached_tail_ - head < count)
+			cached_tail_ = tail_.load(std::memory_order_acquire);
+
+		const size_t used  = cached_tail_ - head;
+		const size_t moved = count < used ? count : used;
+		for (size_t i = 0u; i < moved; ++i)
+			items[i] = std::move(buffer_[(head + i) & mask_]);
+
+		head_.store(head + moved, std::memory_order_release);
+		if (moved != 0u)
+			wake_sleepers();
+		return moved;
+	}
+
+	// Przyblizona ilosc elementow w kolejce (dokladna gdy pyta producent lub konsument).
+	size_t size() const
+	{
+		return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+	}
+
+	size_t capacity() const { return buffer_.size(); }
+
+	void close()
+	{
+		closed_.store(true, std::memory_order_release);
+		wake_sleepers();
+	}
+
+	bool closed() const { return closed_.load(std::memory_order_acquire); }
+
+	// Prawda gdy producent zamknal kolejke i konsument odebral juz wszystkie elementy.
+	bool finished() const
+	{
+		return closed() && size() == 0u;
+	}
+
+	// Czeka az ready() bedzie prawda: najpierw spin_limit prob z yield, potem usypia watek az do
+	// kolejnego push_batch / pop_batch / close / wake. Warunek moze zalezec od stanu spoza kolejki
+	// (np. flagi zatrzymania) - wtedy po jego zmianie trzeba wywolac wake().
+	template<typename Ready>
+	void wait(Ready&& ready)
+	{
+		for (int spin = 0; spin < spin_limit; ++spin)
+		{
+			if (ready())
+				return;
+			std::this_thread::yield();
+		}
+
+		sleepers_.fetch_add(1, std::memory_order_acq_rel);
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			condition_.wait(lock, ready);
+		}
+		sleepers_.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	// Budzi watki uspione w wait() niezaleznie od stanu kolejki.
+	void wake()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		condition_.notify_all();
+	}
+
+	static constexpr int spin_limit = 64;
+
+private:
+	// Odczyt sleepers_ jest operacja read-modify-write po zapisie indeksu. Jesli wypadnie przed zwiekszeniem
+	// sleepers_ w wait() to wait() zobaczy juz nowy indeks sprawdzajac warunek pod mutexem, a jesli po -
+	// watek zostanie obudzony. Zadne przebudzenie nie zostanie wiec zgubione.
+	void wake_sleepers()
+	{
+		if (sleepers_.fetch_add(0, std::memory_order_acq_rel) != 0)
+			wake();
+	}
+
+	std::vector<T> buffer_;
+	const size_t   mask_;
+
+	std::atomic<bool> closed_{false};
+	std::atomic<int>  sleepers_{0};
+	std::mutex              mutex_;
+	std::condition_variable condition_;
+
+	// Indeksy producenta i konsumenta w osobnych liniach pamieci podrecznej (brak false sharing).
+	alignas(64) std::atomic<size_t> tail_{0u};
+	size_t                          cached_head_ = 0u;
+	alignas(64) std::atomic<size_t> head_{0u};
+	size_t                          cached_tail_ = 0u;
+};
+
+
+
+// ---------------- WIELOETAPOWY POTOK PRZETWARZANIA NA WATKACH ----------------//
+
+// Liczniki jednego etapu potoku. Pozwalaja znalezc etap ktory jest waskim gardlem: ma najwiekszy
+// busy_seconds, a kolejka przed nim jest stale pelna (avg_input_occupancy bliskie 1).
+struct pipeline_stage_stats
+{
+	size_t processed           = 0u;  // ilosc przetworzonych elementow
+	size_t batches             = 0u;  // ilosc paczek pobranych z kolejki wejsciowej
+	double busy_seconds        = 0.0; // czas spedzony w funkcji etapu
+	double items_per_second    = 0.0; // processed / busy_seconds
+	double avg_input_occupancy = 0.0; // srednie zapelnienie kolejki wejsciowej (0..1) przy pobieraniu paczki
+	size_t max_input_occupancy = 0u;  // najwieksza zaobserwowana ilosc elementow w kolejce wejsciowej
+};
+
+namespace Impl
+{
+	// Zastepuje void jako typ wyniku ostatniego etapu (kolejka wyjsciowa nie jest wtedy uzywana).
+	struct pipeline_none {};
+
+	template<typename T>
+	struct pipeline_value { using type = std::decay_t<T>; };
+	template<>
+	struct pipeline_value<void> { using type = pipeline_none; };
+
+	template<typename T>
+	struct pipeline_ring { using type = spsc_ring<T>; };
+
+	template<typename Stage>
+	struct pipeline_stage_input
+	{
+		static_assert(function_traits<Stage>::type_pack_args::size::value == 1, "Each pipeline stage has to take exactly one argument.");
+		using type = std::decay_t<typename function_traits<Stage>::type_pack_args::template get<0>>;
+	};
+
+	template<typename Stage>
+	struct pipeline_stage_output { using type = typename pipeline_value<typename function_traits<Stage>::type_result>::type; };
+
+	// Sprawdza czy wynik kazdego etapu (po decay) jest dokladnie typem argumentu kolejnego etapu.
+	template<typename... Stages>
+	struct pipeline_check;
+
+	template<typename Stage>
+	struct pipeline_check<Stage> : std::integral_constant<bool, true> {};
+
+	template<typename Stage, typename Next, typename... Stages>
+	struct pipeline_check<Stage, Next, Stages...> : std::integral_constant<bool,
+		std::is_same<std::decay_t<typename function_traits<Stage>::type_result>, typename pipeline_stage_input<Next>::type>::value &&
+		pipeline_check<Next, Stages...>::value> {};
+
+	struct pipeline_counters
+	{
+		std::atomic<size_t> processed{0u};
+		std::atomic<size_t> batches{0u};
+		std::atomic<size_t> busy_ns{0u};
+		std::atomic<size_t> occupancy_sum{0u};
+		std::atomic<size_t> occupancy_max{0u};
+	};
+}
+
+// Uruchamia kazdy etap (lambde, funktor lub funkcje przyjmujaca jeden argument) na osobnym watku.
+// Etapy sa polaczone ograniczonymi kolejkami spsc_ring i przekazuja sobie elementy paczkami po
+// BatchSize. W trakcie kompilacji (przez function_traits) jest sprawdzane czy typ wyniku kazdego etapu
+// to typ argumentu kolejnego. Dane podaje sie przez push() i konczy przez close(). Jesli ostatni
+// etap cos zwraca to wyniki odbiera sie przez pop(). Destruktor zatrzymuje etapy (nieprzetworzone
+// elementy sa porzucane) i czeka na watki - by przetworzyc wszystko trzeba wczesniej wywolac close() i wait().
+// Watki bez pracy po krotkim czekaniu w petli zasypiaja (spsc_ring::wait).
+// Wyjatek rzucony przez etap zatrzymuje caly potok (elementy w kolejkach sa porzucane), a nastepnie jest
+// rzucany ponownie z pop(), wait(), push() i push_batch() - np. std::invalid_argument z std::stoi ponizej.
+// Uwaga: push() czeka gdy kolejka wejsciowa jest pelna, a ta oprozni sie tylko gdy ktos odbiera wyniki.
+// Jesli ten sam watek najpierw podaje wszystkie dane a dopiero potem wywoluje pop(), potok zakleszczy
+// sie gdy danych jest wiecej niz pojemnosc wszystkich kolejek razem. Wyniki trzeba wtedy odbierac na
+// osobnym watku lub podawac dane przez try_push() przeplatane z odbieraniem.
+// Przyklad uzycia:
+//      auto p = pipeline([](std::string s){ return std::stoi(s); }, [](int x){ return x * 2; });
+//      std::thread consumer([&]{ int result; while (p.pop(result)) { ... } }); // result == 42, ...
+//      for (auto& line : lines) p.push(line);
+//      p.close(); consumer.join();
+template<size_t RingCapacity, size_t BatchSize, typename... Stages>
+class pipeline_executor
+{
+	static_assert(sizeof...(Stages) > 0u, "Pipeline needs at least one stage.");
+	static_assert(Impl::pipeline_check<Stages...>::value, "Result type of each pipeline stage has to match argument type of the next stage.");
+	static_assert(BatchSize > 0u, "BatchSize can't be 0.");
+
+	using values = typename TypePack<typename Impl::pipeline_stage_input<typename get<0u, Stages...>::type>::type>::template
+		append<typename Impl::pipeline_stage_output<Stages>::type...>;
+	using rings  = typename values::template modify<Impl::pipeline_ring>::template unpack_into<std::tuple>;
+
+public:
+	using input_type  = typename values::template get<0u>;
+	using output_type = typename values::template get<sizeof...(Stages)>;
+
+	static constexpr size_t stages() { return sizeof...(Stages); }
+
+	template<typename... Fs>
+	explicit pipeline_executor(Fs&&... stages)
+		: stages_(std::forward<Fs>(stages)...), rings_(make_ring<Stages>()..., make_ring<void>())
+	{
+		start(std::index_sequence_for<Stages...>{});
+	}
+
+	pipeline_executor(const pipeline_executor&) = delete;
+	pipeline_executor& operator=(const pipeline_executor&) = delete;
+
+	~pipeline_executor()
+	{
+		close();
+		stop();
+		join();
+	}
+
+	// Dodaje element na wejscie potoku - czeka gdy kolejka wejsciowa jest pelna.
+	void push(input_type value)
+	{
+		auto& ring = std::get<0u>(rings_);
+		while (ring.push_batch(&value, 1u) == 0u)
+		{
+			if (stopped())
+				return;
+			ring.wait([&]{ return has_space(ring); });
+		}
+	}
+
+	// Dodaje element tylko jesli w kolejce wejsciowej jest miejsce (element jest wtedy przenoszony).
+	bool try_push(input_type& value)
+	{
+		return std::get<0u>(rings_).push_batch(&value, 1u) != 0u;
+	}
+
+	// Dodaje elementy na wejscie potoku jedna paczka (elementy sa przenoszone).
+	void push_batch(input_type* values, size_t count)
+	{
+		auto& ring = std::get<0u>(rings_);
+		for (size_t pushed = 0u; pushed < count; )
+		{
+			const size_t moved = ring.push_batch(values + pushed, count - pushed);
+			pushed += moved;
+			if (moved != 0u)
+				continue;
+			if (stopped())
+				return;
+			ring.wait([&]{ return has_space(ring); });
+		}
+	}
+
+	// Konczy wejscie - etapy koncza prace po przetworzeniu wszystkiego co zostalo dodane.
+	void close() { std::get<0u>(rings_).close(); }
+
+	// Odbiera kolejny wynik ostatniego etapu. Zwraca false gdy potok skonczyl prace i nic nie zostalo.
+	bool pop(output_type& value)
+	{
+		static_assert(!std::is_same<output_type, Impl::pipeline_none>::value, "Last pipeline stage returns void - there is nothing to pop.");
+		auto& ring = std::get<sizeof...(Stages)>(rings_);
+		while (ring.pop_batch(&value, 1u) == 0u)
+		{
+			if (stopped() || ring.finished())
+				return false;
+			ring.wait([&]{ return has_data(ring); });
+		}
+		return true;
+	}
+
+	// Czeka az wszystkie etapy skoncza prace (wymaga wczesniejszego close()).
+	void wait()
+	{
+		join();
+		rethrow_stage_error();
+	}
+
+	pipeline_stage_stats stats(size_t stage) const
+	{
+		const Impl::pipeline_counters& c = counters_[stage];
+		pipeline_stage_stats s;
+		s.processed           = c.processed.load(std::memory_order_relaxed);
+		s.batches             = c.batches.load(std::memory_order_relaxed);
+		s.busy_seconds        = c.busy_ns.load(std::memory_order_relaxed) * 1e-9;
+		s.items_per_second    = s.busy_seconds > 0.0 ? s.processed / s.busy_seconds : 0.0;
+		s.avg_input_occupancy = s.batches ? double(c.occupancy_sum.load(std::memory_order_relaxed)) / s.batches / Impl::spsc_capacity(RingCapacity) : 0.0;
+		s.max_input_occupancy = c.occupancy_max.load(std::memory_order_relaxed);
+		return s;
+	}
+
+private:
+	template<typename>
+	static size_t make_ring() { return RingCapacity; }
+
+	void stop()
+	{
+		stop_.store(true, std::memory_order_seq_cst);
+		std::apply([](auto&... rings){ using Swallow = int[]; (void)Swallow{0, (void(rings.wake()), 0)... }; }, rings_);
+	}
+
+	void join()
+	{
+		for (auto& thread : threads_)
+			if (thread.joinable())
+				thread.join();
+	}
+
+	// Prawda gdy potok zostal zatrzymany - jesli przez wyjatek w etapie to jest on rzucany ponownie.
+	bool stopped()
+	{
+		if (!stop_.load(std::memory_order_acquire))
+			return false;
+		rethrow_stage_error();
+		return true;
+	}
+
+	void rethrow_stage_error()
+	{
+		if (failed_.load(std::memory_order_acquire))
+			std::rethrow_exception(error_);
+	}
+
+	// Zapamietuje pierwszy wyjatek rzucony przez ktorykolwiek etap i zatrzymuje caly potok.
+	void stage_failed(std::exception_ptr error)
+	{
+		{
+			std::lock_guard<std::mutex> lock(error_mutex_);
+			if (failed_.load(std::memory_order_relaxed))
+				return;
+			error_ = std::move(error);
+			failed_.store(true, std::memory_order_release);
+		}
+		stop();
+	}
+
+	template<typename Ring>
+	bool has_space(const Ring& ring) const { return ring.size() < ring.capacity() || stop_.load(std::memory_order_relaxed); }
+
+	template<typename Ring>
+	bool has_data(const Ring& ring) const { return ring.size() != 0u || ring.closed() || stop_.load(std::memory_order_relaxed); }
+
+	template<size_t... Is>
+	void start(std::index_sequence<Is...>)
+	{
+		using Swallow = int[];
+		(void)Swallow{0, (void( threads_[Is] = std::thread([this]{ run_stage<Is>(); }) ), 0)... };
+	}
+
+	template<size_t I>
+	void run_stage()
+	{
+		using In  = typename values::template get<I>;
+		using Out = typename values::template get<I + 1u>;
+		constexpr bool has_output = !std::is_same<Out, Impl::pipeline_none>::value;
+
+		auto& stage    = std::get<I>(stages_);
+		auto& input    = std::get<I>(rings_);
+		auto& output   = std::get<I + 1u>(rings_);
+		auto& counters = counters_[I];
+
+		std::vector<In>  in_batch(BatchSize);
+		std::vector<Out> out_batch(has_output ? BatchSize : 0u);
+
+		while (!stop_.load(std::memory_order_relaxed))
+		{
+			const size_t occupancy = input.size();
+			const size_t count = input.pop_batch(in_batch.data(), BatchSize);
+			if (count == 0u)
+			{
+				if (input.finished())
+					break;
+				input.wait([&]{ return has_data(input); });
+				continue;
+			}
+
+			const auto begin = std::chrono::steady_clock::now();
+			try
+			{
+				for (size_t i = 0u; i < count; ++i)
+				{
+					if constexpr (has_output)
+						out_batch[i] = stage(std::move(in_batch[i]));
+					else
+						stage(std::move(in_batch[i]));
+				}
+			}
+			catch (...)
+			{
+				stage_failed(std::current_exception());
+				break;
+			}
+			const auto end = std::chrono::steady_clock::now();
+
+			counters.processed.fetch_add(count, std::memory_order_relaxed);
+			counters.batches.fetch_add(1u, std::memory_order_relaxed);
+			counters.busy_ns.fetch_add(size_t(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()), std::memory_order_relaxed);
+			counters.occupancy_sum.fetch_add(occupancy, std::memory_order_relaxed);
+			if (occupancy > counters.occupancy_max.load(std::memory_order_relaxed))
+				counters.occupancy_max.store(occupancy, std::memory_order_relaxed);
+
+			if constexpr (has_output)
+			{
+				for (size_t pushed = 0u; pushed < count && !stop_.load(std::memory_order_relaxed); )
+				{
+					const size_t moved = output.push_batch(out_batch.data() + pushed, count - pushed);
+					pushed += moved;
+					if (moved == 0u)
+						output.wait([&]{ return has_space(output); });
+				}
+			}
+		}
+		output.close();
+	}
+
+	std::tuple<Stages...>          stages_;
+	rings                          rings_;
+	Impl::pipeline_counters        counters_[sizeof...(Stages)];
+	std::thread                    threads_[sizeof...(Stages)];
+	std::atomic<bool>              stop_{false};
+	std::atomic<bool>              failed_{false};
+	std::exception_ptr             error_;
+	std::mutex                     error_mutex_;
+};
+
+// Tworzy potok z podanych etapow (patrz pipeline_executor). Pojemnosc kolejek i wielkosc paczek
+// mozna podac w szablonie: pipeline<4096, 256>(parse, transform, encode).
+template<size_t RingCapacity = 1024u, size_t BatchSize = 64u, typename... Stages>
+pipeline_executor<RingCapacity, BatchSize, std::decay_t<Stages>...> pipeline(Stages&&... stages)
+{
+	return pipeline_executor<RingCapacity, BatchSize, std::decay_t<Stages>...>(std::forward<Stages>(stages)...);
+}
+
+
+
+namespace _compile_time_tests
+{
+struct StageParse  { int operator()(const char*) const { return 0; } };
+struct StageDouble { long operator()(int) const { return 0; } };
+struct StageRef    { float operator()(const long&) const { return 0.f; } };
+struct StageSink   { void operator()(float) const {} };
+
+static_assert(Impl::pipeline_check<StageParse>::value, "FAIL");
+static_assert(Impl::pipeline_check<StageParse, StageDouble, StageRef, StageSink>::value, "FAIL");
+static_assert(!Impl::pipeline_check<StageParse, StageRef>::value, "FAIL");
+static_assert(!Impl::pipeline_check<StageDouble, StageDouble>::value, "FAIL");
+static_assert(!Impl::pipeline_check<StageSink, StageDouble>::value, "FAIL");
+static_assert(std::is_same<Impl::pipeline_stage_output<StageSink>::type, Impl::pipeline_none>::value, "FAIL");
+static_assert(std::is_same<pipeline_executor<16, 4, StageParse, StageDouble>::output_type, long>::value, "FAIL");
+}
+
+
+}
@@ -0,0 +1,564 @@
+// Autor: Aron Mandrella
+//
+// Mikrobenchmarki czesci biblioteki ktore dzialaja w trakcie wykonania programu (for_each_value,
+// aligned_storage, inplace_function / function_traits, uklad rekordow opisanych paczka typow,
+// command_buffer, relocate_n przy zmianie rozmiaru tablicy rekordow).
+// Bez zewnetrznych zaleznosci - czas mierzony przez std::chrono::steady_clock, dla kazdego pomiaru
+// brany jest najlepszy wynik z kilku powtorzen. Wyniki sa wypisywane jako CSV (na standardowe
+// wyjscie lub do pliku podanego jako pierwszy argument) by mozna je bylo porownywac miedzy wersjami.
+//
+// Uzycie:
+//     g++ -std=c++17 -O2 benchmark/benchmark.cpp -o tpack_benchmark
+//     ./tpack_benchmark results.csv
+
+#include "../TypePack.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace tpack;
+
+
+namespace
+{
+	// Nie pozwala kompilatorowi usunac obliczen ktorych wynik nie jest dalej uzywany.
+	template<typename T>
+	inline void do_not_optimize(const T& value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static volatile const void* sink;
+		sink = &value;
+#endif
+	}
+
+	struct result
+	{
+		std::string group;
+		std::string variant;
+		std::string metric;
+		double      value;
+	};
+
+	std::vector<result> results;
+
+	// Zwraca najlepszy czas (w nanosekundach) na jedna operacje z kilku powtorzen.
+	template<typename Function>
+	double measure(size_t operations, Function&& f)
+	{
+		constexpr int repetitions = 7;
+		double best = 0.0;
+		for (int r = 0; r < repetitions; ++r)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			f();
+			const auto stop = std::chrono::steady_clock::now();
+			const double ns = std::chrono::duration<double, std::nano>(stop - start).count() / operations;
+			best = (r == 0 || ns < best) ? ns : best;
+		}
+		return best;
+	}
+
+	void report(const std::string& group, const std::string& variant, const std::string& metric, double value)
+	{
+		results.push_back({ group, variant, metric, value });
+	}
+
+	// Benchmarki ktore licza ten sam wynik na dwa sposoby sprawdzaja tez czy wyniki sa zgodne.
+	void verify(bool ok, const char* what)
+	{
+		if (!ok)
+		{
+			std::cerr << "Benchmark check failed: " << what << "\n";
+			std::exit(EXIT_FAILURE);
+		}
+	}
+
+
+
+	// ----------- for_each_value vs std::apply -----------//
+
+	using Record = TypePack<double, float, int, short, char, long long>;
+
+	void bench_for_each_value()
+	{
+		constexpr size_t count = 1u << 20;
+		std::vector<Record::unpack_into<std::tuple>> records(count);
+		for (size_t i = 0; i < count; ++i)
+			records[i] = std::make_tuple(i * 0.5, i * 0.25f, int(i), short(i), char(i), (long long)i);
+
+		report("for_each_value", "for_each_value", "ns_per_record", measure(count, [&]
+		{
+			double sum = 0.0;
+			for (auto& record : records)
+				for_each_value(record, [&sum](size_t, auto& v){ sum += v; });
+			do_not_optimize(sum);
+		}));
+
+		report("for_each_value", "std::apply", "ns_per_record", measure(count, [&]
+		{
+			double sum = 0.0;
+			for (auto& record : records)
+				std::apply([&sum](auto&... v){ using Swallow = int[]; (void)Swallow{0, (void( sum += v ), 0)... }; }, record);
+			do_not_optimize(sum);
+		}));
+	}
+
+
+
+	// ----------- aligned_storage vs std::tuple -----------//
+
+	template<typename Pack>
+	struct storage_record;
+
+	template<typename... Ts>
+	struct storage_record<TypePack<Ts...>>
+	{
+		typename TypePack<Ts...>::aligned_storage storage;
+
+		template<size_t I>
+		typename TypePack<Ts...>::template get<I>& get()
+		{
+			return *reinterpret_cast<typename TypePack<Ts...>::template get<I>*>(
+				reinterpret_cast<unsigned char*>(&storage) + aligned_offset<I, Ts...>());
+		}
+	};
+
+	using PaddedRecord = TypePack<char, double, char, int, char, short>;
+
+	void bench_aligned_storage()
+	{
+		using Tuple   = PaddedRecord::unpack_into<std::tuple>;
+		using Storage = storage_record<PaddedRecord>;
+		static_assert(std::is_trivially_copyable<Storage>::value, "");
+
+		report("aligned_storage", "aligned_storage", "bytes", sizeof(Storage));
+		report("aligned_storage", "std::tuple",      "bytes", sizeof(Tuple));
+
+		constexpr size_t count = 1u << 18;
+		std::vector<Storage> storages(count), storages_copy(count);
+		std::vector<Tuple>   tuples(count),   tuples_copy(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			storages[i].get<1>() = double(i);
+			std::get<1>(tuples[i]) = double(i);
+		}
+
+		report("aligned_storage", "aligned_storage", "ns_per_copy", measure(count, [&]
+		{
+			std::copy(storages.begin(), storages.end(), storages_copy.begin());
+			do_not_optimize(storages_copy.back());
+		}));
+
+		report("aligned_storage", "std::tuple", "ns_per_copy", measure(count, [&]
+		{
+			std::copy(tuples.begin(), tuples.end(), tuples_copy.begin());
+			do_not_optimize(tuples_copy.back());
+		}));
+	}
+
+
+
+	// ----------- AoS vs SoA dla rekordow opisanych paczka typow -----------//
+
+	using Particle = TypePack<float, float, float, float, float, float, int>;
+
+	template<typename T>
+	struct vector_of { using type = std::vector<T>; };
+
+	void bench_aos_soa()
+	{
+		constexpr size_t count = 1u << 20;
+		std::vector<Particle::unpack_into<std::tuple>> aos(count);
+		Particle::modify<vector_of>::unpack_into<std::tuple> soa;
+		for_each_value(soa, [](size_t, auto& column){ column.resize(count); });
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			std::get<0>(aos[i]) = float(i);
+			std::get<0>(soa)[i] = float(i);
+		}
+
+		// Odczyt jednego pola z kazdego rekordu.
+		report("aos_soa", "aos", "ns_per_record", measure(count, [&]
+		{
+			float sum = 0.f;
+			for (const auto& particle : aos)
+				sum += std::get<0>(particle);
+			do_not_optimize(sum);
+		}));
+
+		report("aos_soa", "soa", "ns_per_record", measure(count, [&]
+		{
+			float sum = 0.f;
+			for (float x : std::get<0>(soa))
+				sum += x;
+			do_not_optimize(sum);
+		}));
+	}
+
+
+
+	// ----------- inplace_function vs std::function -----------//
+
+	void bench_callbacks()
+	{
+		constexpr size_t count = 1u << 20;
+		const long long a = 1, b = 2, c = 3, d = 4;
+
+		// Przechwycone 32 bajty - za duzo na wewnetrzny bufor std::function w popularnych implementacjach.
+		auto lambda = [a, b, c, d](int x){ return x * a + b - c + d; };
+		using Signature = function_traits<decltype(lambda)>::type_signature;
+
+		report("callbacks", "inplace_function", "ns_per_construct", measure(count, [&]
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				inplace_function<Signature, 32> f = lambda;
+				do_not_optimize(f);
+			}
+		}));
+
+		report("callbacks", "std::function", "ns_per_construct", measure(count, [&]
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				std::function<Signature> f = lambda;
+				do_not_optimize(f);
+			}
+		}));
+
+		inplace_function<Signature, 32> inplace = lambda;
+		std::function<Signature>        function = lambda;
+
+		report("callbacks", "inplace_function", "ns_per_call", measure(count, [&]
+		{
+			long long sum = 0;
+			for (size_t i = 0; i < count; ++i)
+				sum += inplace(int(i));
+			do_not_optimize(sum);
+		}));
+
+		report("callbacks", "std::function", "ns_per_call", measure(count, [&]
+		{
+			long long sum = 0;
+			for (size_t i = 0; i < count; ++i)
+				sum += function(int(i));
+			do_not_optimize(sum);
+		}));
+	}
+
+
+
+	// ----------- command_buffer vs std::vector<std::unique_ptr<Command>> -----------//
+
+	struct Command { virtual ~Command() = default; virtual void execute(long long& state) = 0; };
+
+	struct SetColor  { unsigned color; };
+	struct Translate { float x, y, z; };
+	struct DrawMesh  { unsigned mesh; unsigned instances; };
+	struct Scissor   { short x, y, w, h; };
+
+	long long apply_command(long long state, const SetColor& c)  { return state + c.color; }
+	long long apply_command(long long state, const Translate& c) { return state + (long long)c.x; }
+	long long apply_command(long long state, const DrawMesh& c)  { return state + c.mesh * c.instances; }
+	long long apply_command(long long state, const Scissor& c)   { return state + c.w * c.h; }
+
+	// Polecenia nietrywialne (wlasciciel pamieci) i z duzym align - command_buffer niszczy je i przenosi
+	// przy powiekszaniu obiekt po obiekcie.
+	struct SetLabel              { std::string label; };
+	struct alignas(32) Transform { float m[8]; };
+
+	long long apply_command(long long state, const SetLabel& c)  { return state + (long long)c.label.size(); }
+	long long apply_command(long long state, const Transform& c) { return state + (long long)c.m[0] + (reinterpret_cast<std::uintptr_t>(&c) % 32u); }
+
+	template<typename T>
+	struct polymorphic_command final : Command
+	{
+		T data;
+		explicit polymorphic_command(const T& d) : data(d) {}
+		void execute(long long& state) override { state = apply_command(state, data); }
+	};
+
+	template<typename Function>
+	void record_frame(size_t frame, size_t count, Function&& f)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			switch ((i + frame) % 4u)
+			{
+			case 0: f(SetColor{ unsigned(i) }); break;
+			case 1: f(Translate{ float(i), 0.f, 1.f }); break;
+			case 2: f(DrawMesh{ unsigned(i), 2u }); break;
+			default: f(Scissor{ 0, 0, short(i % 100), 2 }); break;
+			}
+		}
+	}
+
+	template<typename Function>
+	void record_owning_frame(size_t count, Function&& f)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			switch (i % 3u)
+			{
+			case 0: f(SetColor{ unsigned(i) }); break;
+			case 1: f(SetLabel{ "label-with-heap-storage-" + std::to_string(i) }); break;
+			default: f(Transform{ { float(i) } }); break;
+			}
+		}
+	}
+
+	// Dodawanie kopii polecenia lezacego w tym samym buforze - przy powiekszaniu nowe polecenie jest
+	// tworzone zanim stare zostana przeniesione, wiec referencja jest wciaz wazna.
+	void check_command_buffer_self_push()
+	{
+		command_buffer<TypePack<SetColor, SetLabel, Transform>> buffer;
+		SetLabel* last = &buffer.emplace<SetLabel>(SetLabel{ "label-with-heap-storage" });
+		for (int i = 0; i < 1000; ++i)
+			last = &buffer.push(*last);
+
+		bool ok = buffer.size() == 1001u;
+		buffer.replay([&](const auto& cmd)
+		{
+			if constexpr (std::is_same<std::decay_t<decltype(cmd)>, SetLabel>::value)
+				ok = ok && cmd.label == "label-with-heap-storage";
+		});
+		verify(ok, "command_buffer push of a command from the same buffer");
+	}
+
+	// Kazde powtorzenie zaczyna od pustego bufora, wiec mierzone jest tez przenoszenie przy powiekszaniu.
+	void bench_owning_commands()
+	{
+		check_command_buffer_self_push();
+
+		constexpr size_t count = 1u << 14;
+
+		long long buffer_state = 0;
+		report("command_buffer_owning", "command_buffer", "ns_per_command", measure(count, [&]
+		{
+			command_buffer<TypePack<SetColor, SetLabel, Transform>> buffer;
+			record_owning_frame(count, [&](auto&& cmd){ buffer.push(std::move(cmd)); });
+			buffer_state = 0;
+			buffer.replay([&](const auto& cmd){ buffer_state = apply_command(buffer_state, cmd); });
+			buffer.reset();
+		}));
+
+		long long vector_state = 0;
+		report("command_buffer_owning", "vector<unique_ptr>", "ns_per_command", measure(count, [&]
+		{
+			std::vector<std::unique_ptr<Command>> commands;
+			record_owning_frame(count, [&](auto&& cmd)
+			{
+				commands.push_back(std::make_unique<polymorphic_command<std::decay_t<decltype(cmd)>>>(cmd));
+			});
+			vector_state = 0;
+			for (auto& command : commands)
+				command->execute(vector_state);
+		}));
+
+		verify(buffer_state == vector_state, "command_buffer replay of owning / over-aligned commands");
+	}
+
+	void bench_command_buffer()
+	{
+		constexpr size_t count  = 1u << 14;
+		constexpr size_t frames = 16u;
+
+		command_buffer<TypePack<SetColor, Translate, DrawMesh, Scissor>> buffer;
+		report("command_buffer", "command_buffer", "ns_per_command", measure(count * frames, [&]
+		{
+			long long state = 0;
+			for (size_t frame = 0; frame < frames; ++frame)
+			{
+				record_frame(frame, count, [&](const auto& cmd){ buffer.push(cmd); });
+				buffer.replay([&](const auto& cmd){ state = apply_command(state, cmd); });
+				buffer.reset();
+			}
+			do_not_optimize(state);
+		}));
+
+		std::vector<std::unique_ptr<Command>> commands;
+		report("command_buffer", "vector<unique_ptr>", "ns_per_command", measure(count * frames, [&]
+		{
+			long long state = 0;
+			for (size_t frame = 0; frame < frames; ++frame)
+			{
+				record_frame(frame, count, [&](const auto& cmd)
+				{
+					commands.push_back(std::make_unique<polymorphic_command<std::decay_t<decltype(cmd)>>>(cmd));
+				});
+				for (auto& command : commands)
+					command->execute(state);
+				commands.clear();
+			}
+			do_not_optimize(state);
+		}));
+
+		bench_owning_commands();
+	}
+}
+
+
+
+// ----------- Zmiana rozmiaru tablicy rekordow: relocate_n vs przenoszenie obiekt po obiekcie -----------//
+
+namespace
+{
+	// Typ nietrywialny (wlasny konstruktor przenoszacy i destruktor) ale bezpieczny do przeniesienia memcpy.
+	struct Handle
+	{
+		int* resource = nullptr;
+		Handle() = default;
+		Handle(Handle&& other) noexcept : resource(other.resource) { other.resource = nullptr; }
+		~Handle() { delete resource; }
+	};
+}
+
+template<>
+struct tpack::is_trivially_relocatable<Handle> : std::true_type {};
+
+namespace
+{
+	using Tracked = TypePack<double, float, int, Handle>;
+	static_assert(Tracked::is_trivially_relocatable() && !Tracked::is_trivially_copyable(), "");
+
+	template<typename... Us, size_t... Is>
+	void relocate_per_object(TypePack<Us...>, std::index_sequence<Is...>, unsigned char* src, unsigned char* dst)
+	{
+		using Swallow = int[];
+		(void)Swallow{0, (void((
+			new (dst + aligned_offset<Is, Us...>()) Us(std::move(*std::launder(reinterpret_cast<Us*>(src + aligned_offset<Is, Us...>())))),
+			std::launder(reinterpret_cast<Us*>(src + aligned_offset<Is, Us...>()))->~Us() )), 0)... };
+	}
+
+	// Dodaje count rekordow do tablicy podwajajac jej pojemnosc gdy sie skonczy (jak std::vector).
+	template<typename Pack, typename Relocate>
+	void grow_records(size_t count, Relocate&& relocate)
+	{
+		using Record = typename Pack::aligned_storage;
+		size_t capacity = 16u, size = 0u;
+		Record* records = new Record[capacity];
+		for (; size < count; ++size)
+		{
+			if (size == capacity)
+			{
+				Record* bigger = new Record[capacity * 2u];
+				relocate(records, size, bigger);
+				delete[] records;
+				records = bigger;
+				capacity *= 2u;
+			}
+			Pack::uninitialized_construct_n(records + size, 1u);
+		}
+		do_not_optimize(records[size - 1u]);
+		Pack::destroy_n(records, size);
+		delete[] records;
+	}
+
+	// Sprawdza poprawnosc operacji na rekordach przed pomiarami: przeniesienie zachowuje wartosci i zasoby,
+	// a wyjatek z konstruktora w uninitialized_construct_n niszczy juz utworzone obiekty.
+	struct Counted
+	{
+		static inline int live = 0, fail_at = -1;
+		Counted() { if (live == fail_at) throw 1; ++live; }
+		Counted(Counted&&) noexcept { ++live; }
+		~Counted() { --live; }
+	};
+
+	void check_records()
+	{
+		using Record = Tracked::aligned_storage;
+		constexpr size_t count = 100u;
+		Record src[count], dst[count];
+		Tracked::uninitialized_construct_n(src, count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			*reinterpret_cast<int*>(reinterpret_cast<unsigned char*>(src + i) + aligned_offset<2, double, float, int, Handle>()) = int(i);
+			reinterpret_cast<Handle*>(reinterpret_cast<unsigned char*>(src + i) + aligned_offset<3, double, float, int, Handle>())->resource = new int(int(i));
+		}
+		Tracked::relocate_n(src, count, dst);
+		bool ok = true;
+		for (size_t i = 0; i < count; ++i)
+		{
+			const unsigned char* record = reinterpret_cast<const unsigned char*>(dst + i);
+			ok = ok && *reinterpret_cast<const int*>(record + aligned_offset<2, double, float, int, Handle>()) == int(i)
+			        && *reinterpret_cast<const Handle*>(record + aligned_offset<3, double, float, int, Handle>())->resource == int(i);
+		}
+		Tracked::destroy_n(dst, count);
+		verify(ok, "relocate_n keeps record values and resources");
+
+		using Throwing = TypePack<Counted, std::string, Counted>;
+		Throwing::aligned_storage records[4];
+		Counted::fail_at = 5;
+		try { Throwing::uninitialized_construct_n(records, 4u); } catch (int) {}
+		verify(Counted::live == 0, "uninitialized_construct_n destroys built objects when a constructor throws");
+		Counted::fail_at = -1;
+		Throwing::uninitialized_construct_n(records, 4u);
+		Throwing::aligned_storage moved[4];
+		Throwing::relocate_n(records, 4u, moved);
+		verify(Counted::live == 8, "relocate_n moves each object exactly once");
+		Throwing::destroy_n(moved, 4u);
+		verify(Counted::live == 0, "destroy_n destroys every object");
+	}
+
+	void bench_resize()
+	{
+		check_records();
+
+		constexpr size_t count = 1u << 20;
+		using Record = Tracked::aligned_storage;
+
+		report("resize", "relocate_n", "ns_per_record", measure(count, [&]
+		{
+			grow_records<Tracked>(count, [](Record* src, size_t n, Record* dst){ Tracked::relocate_n(src, n, dst); });
+		}));
+
+		report("resize", "per_object", "ns_per_record", measure(count, [&]
+		{
+			grow_records<Tracked>(count, [](Record* src, size_t n, Record* dst)
+			{
+				for (size_t i = 0; i < n; ++i)
+					relocate_per_object(Tracked(), std::index_sequence_for<double, float, int, Handle>{},
+						reinterpret_cast<unsigned char*>(src + i), reinterpret_cast<unsigned char*>(dst + i));
+			});
+		}));
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	bench_for_each_value();
+	bench_aligned_storage();
+	bench_aos_soa();
+	bench_callbacks();
+	bench_command_buffer();
+	bench_resize();
+
+	std::ofstream file;
+	if (argc > 1)
+	{
+		file.open(argv[1]);
+		if (!file)
+		{
+			std::cerr << "Can't open output file: " << argv[1] << "\n";
+			return EXIT_FAILURE;
+		}
+	}
+	std::ostream& out = (argc > 1) ? file : std::cout;
+
+	out << "group,variant,metric,value\n";
+	for (const auto& r : results)
+		out << r.group << ',' << r.variant << ',' << r.metric << ',' << r.value << '\n';
+
+	return out ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,172 @@
+// Autor: Aron Mandrella
+//
+// Generator naglowka z wczesniej policzonymi wynikami operacji na paczkach typow. Gdy paczki komponentow
+// i systemow sa stale, kazda jednostka kompilacji liczy od nowa remove_repetitions, filter, contains_indexes
+// itd. Ten program liczy je raz (w trakcie wlasnej kompilacji) i wypisuje naglowek z samymi aliasami:
+//
+//     using UsedStructs      = tpack::TypePack<...>;
+//     using ComponentIndexes = std::index_sequence<...>;
+//
+// oraz static_assert-y sprawdzajace (tylko gdy zdefiniowano TPACK_PRECOMPUTE_CHECK) czy wygenerowane
+// wyniki nadal zgadzaja sie z tym co liczy biblioteka - wystarczy ze jedna jednostka kompilacji
+// (np. testy) zdefiniuje to makro by nieaktualny naglowek nie przeszedl niezauwazony.
+//
+// Wejscie: naglowek podany w makrze TPACK_PRECOMPUTE_INPUT, ktory definiuje wpisy w przestrzeni nazw
+// tpack_precompute oraz makro TPACK_PRECOMPUTE_ENTRIES(X) z ich lista (przyklad: precompute_example.hpp).
+// Wyjscie: plik podany jako pierwszy argument programu (lub standardowe wyjscie). Wygenerowany naglowek
+// dolacza plik wejsciowy sciezka wzgledna do miejsca w ktorym zostal zapisany. Sciezka jest liczona
+// od katalogu tego pliku zrodlowego, wiec program trzeba uruchomic z katalogu w ktorym byl kompilowany.
+// Jesli plik wejsciowy byl znaleziony przez -I (lub program jest uruchamiany z innego miejsca) sciezke
+// do wpisania w #include trzeba podac jako drugi argument.
+//
+// Uzycie:
+//     g++ -std=c++17 -DTPACK_PRECOMPUTE_INPUT='"precompute_example.hpp"' tools/precompute.cpp -o precompute
+//     ./precompute packs_precomputed.hpp
+//     ./precompute include/packs_precomputed.hpp "../tools/precompute_example.hpp"
+//
+// Uwaga: nazwy typow sa odczytywane przez abi::__cxa_demangle, wiec generator wymaga GCC lub Clang
+// (wygenerowany naglowek jest juz zwyklym C++). Typy musza byc nazwane (bez lambd i typow lokalnych).
+// Uwaga 2: deklaracje 'extern template' nic tu nie daja - metafunkcje maja tylko aliasy typow, a jawna
+// deklaracja instancji i tak wymusza pelna instancjacje klasy w kazdej jednostce kompilacji.
+
+#include <cxxabi.h>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#ifndef TPACK_PRECOMPUTE_INPUT
+#define TPACK_PRECOMPUTE_INPUT "precompute_example.hpp"
+#endif
+#include TPACK_PRECOMPUTE_INPUT
+
+
+namespace
+{
+	// Nazwa typu razem z kwalifikatorami const/volatile i referencjami (typeid je gubi, wiec typ
+	// jest najpierw pakowany w TypeWrapper i odpakowywany z nazwy po demanglingu).
+	template<typename T>
+	struct type_name
+	{
+		static std::string get()
+		{
+			int status = 0;
+			std::unique_ptr<char, void(*)(void*)> name(
+				abi::__cxa_demangle(typeid(tpack::TypeWrapper<T>).name(), nullptr, nullptr, &status), std::free);
+			if (status != 0)
+				throw std::runtime_error(std::string("Can't demangle type name: ") + typeid(T).name());
+
+			const std::string wrapped = name.get();
+			const size_t begin = wrapped.find('<') + 1u;
+			const size_t end   = wrapped.rfind('>');
+			return wrapped.substr(begin, end - begin);
+		}
+	};
+
+	template<typename... Ts>
+	struct type_name<tpack::TypePack<Ts...>>
+	{
+		static std::string get()
+		{
+			std::string result = "tpack::TypePack<";
+			size_t index = 0;
+			using Swallow = int[];
+			(void)Swallow{0, (void( result += (index++ ? ", " : "") + type_name<Ts>::get() ), 0)... };
+			return result + ">";
+		}
+	};
+
+	template<size_t... I>
+	struct type_name<tpack::Sequence<I...>>
+	{
+		static std::string get()
+		{
+			std::string result = "std::index_sequence<";
+			size_t index = 0;
+			using Swallow = int[];
+			(void)Swallow{0, (void( result += (index++ ? ", " : "") + std::to_string(I) ), 0)... };
+			return result + ">";
+		}
+	};
+
+	// Wpis moze byc metafunkcja (ma pole ::type) lub od razu wynikiem.
+	template<typename T, typename = void>
+	struct entry_result { using type = T; static constexpr bool metafunction = false; };
+
+	template<typename T>
+	struct entry_result<T, std::void_t<typename T::type>> { using type = typename T::type; static constexpr bool metafunction = true; };
+
+	// Sciezka pliku wejsciowego wzgledem katalogu w ktorym zostanie zapisany wygenerowany naglowek.
+	std::string input_include_path(const char* output)
+	{
+		namespace fs = std::filesystem;
+		const fs::path input = fs::absolute(fs::path(__FILE__).parent_path() / TPACK_PRECOMPUTE_INPUT);
+		if (!fs::exists(input))
+			throw std::runtime_error("Can't find input header " + input.string() +
+				" - pass the path to use in #include as the second argument.");
+
+		const fs::path output_dir = fs::absolute(output ? fs::path(output) : fs::path("stdout")).parent_path();
+		return input.lexically_relative(output_dir).generic_string();
+	}
+
+	template<typename Entry>
+	void emit(const char* name, std::ostream& aliases, std::ostream& checks)
+	{
+		aliases << "\tusing " << name << " = " << type_name<typename entry_result<Entry>::type>::get() << ";\n";
+
+		const std::string live = entry_result<Entry>::metafunction
+			? std::string("typename tpack_precompute::") + name + "::type"
+			: std::string("tpack_precompute::") + name;
+		checks << "static_assert(std::is_same<tpack_precomputed::" << name << ", " << live << ">::value,\n"
+		       << "\t\"tpack_precomputed::" << name << " is out of date - regenerate this header.\");\n";
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	std::ostringstream aliases, checks;
+	std::string include;
+	try
+	{
+#define TPACK_PRECOMPUTE_EMIT(name) emit<tpack_precompute::name>(#name, aliases, checks);
+		TPACK_PRECOMPUTE_ENTRIES(TPACK_PRECOMPUTE_EMIT)
+#undef TPACK_PRECOMPUTE_EMIT
+		include = (argc > 2) ? argv[2] : input_include_path(argc > 1 ? argv[1] : nullptr);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << "\n";
+		return EXIT_FAILURE;
+	}
+
+	std::ofstream file;
+	if (argc > 1)
+	{
+		file.open(argv[1]);
+		if (!file)
+		{
+			std::cerr << "Can't open output file: " << argv[1] << "\n";
+			return EXIT_FAILURE;
+		}
+	}
+	std::ostream& out = (argc > 1) ? file : std::cout;
+
+	out << "// Plik wygenerowany przez tools/precompute.cpp - nie edytowac recznie.\n"
+	    << "// Wejscie: " << TPACK_PRECOMPUTE_INPUT << "\n\n"
+	    << "#pragma once\n"
+	    << "#include <utility>\n"
+	    << "#include \"" << include << "\"\n\n"
+	    << "namespace tpack_precomputed\n{\n"
+	    << aliases.str()
+	    << "}\n\n"
+	    << "#ifdef TPACK_PRECOMPUTE_CHECK\n"
+	    << checks.str()
+	    << "#endif\n";
+
+	return out ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,40 @@
+// Autor: Aron Mandrella
+//
+// Przykladowy plik wejsciowy dla tools/precompute.cpp. Opisuje wyrazenia na paczkach typow ktore
+// maja zostac policzone raz i zapisane w wygenerowanym naglowku jako zwykle aliasy.
+//
+// Kazdy wpis to alias w przestrzeni nazw tpack_precompute. Moze to byc od razu paczka typow lub
+// metafunkcja z polem ::type (np. tpack::remove_repetitions<...>). Warto uzywac metafunkcji bo samo
+// nazwanie specjalizacji nic nie liczy - ten plik moze byc wtedy tanio dolaczany do wygenerowanego
+// naglowka (jest potrzebny by typy uzyte w wynikach byly zadeklarowane).
+
+#pragma once
+#include "../TypePack.hpp"
+
+namespace tpack_example
+{
+	struct Tag1{};
+	struct Tag2{};
+	struct Component1{ int x; };
+	struct Component2{ int x; };
+	struct Component3{ int x; };
+
+	using Structs = tpack::TypePack<Component1, Component2, Tag1, Component2, Component3, Tag2, Tag1>;
+}
+
+namespace tpack_precompute
+{
+	using namespace tpack_example;
+
+	using UsedStructs      = tpack::remove_repetitions<Component1, Component2, Tag1, Component2, Component3, Tag2, Tag1>;
+	using Components       = tpack::pipe<Structs, tpack::stage::remove_repetitions, tpack::stage::filter_inv<std::is_empty>>;
+	using Tags             = tpack::pipe<Structs, tpack::stage::remove_repetitions, tpack::stage::filter<std::is_empty>>;
+	using ComponentIndexes = tpack::contains_indexes<tpack::TypePack<Component1, Component2, Component3>, Component1, Component3>;
+}
+
+// Lista wpisow ktore maja zostac wygenerowane.
+#define TPACK_PRECOMPUTE_ENTRIES(X) \
+	X(UsedStructs)                  \
+	X(Components)                   \
+	X(Tags)                         \
+	X(ComponentIndexes)